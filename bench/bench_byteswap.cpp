@@ -0,0 +1,76 @@
+/**
+ * @file bench_byteswap.cpp
+ * @brief Throughput of each byte-swap kernel against a plain memcpy
+ *
+ * Every kernel the CPU supports is verified against the scalar path on the
+ * full buffer before it is timed. Throughput counts bytes read plus written,
+ * like the memcpy reference.
+ *
+ * Usage: bench_byteswap [bins] [rounds]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../tpx3_byteswap.h"
+
+namespace {
+
+template <typename Op>
+double gigabytes_per_second(size_t bytes, int rounds, Op op) {
+    op();  // Warm up caches and page tables
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        op();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return 2.0 * bytes * rounds / seconds / 1e9;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t bins = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 200;
+    if (bins == 0 || rounds <= 0) {
+        std::fprintf(stderr, "Usage: %s [bins] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<uint32_t> source(bins);
+    for (size_t i = 0; i < bins; ++i) {
+        source[i] = static_cast<uint32_t>(i * 2654435761u);
+    }
+    std::vector<uint32_t> expected(source);
+    byteswap::swap_scalar(expected.data(), bins);
+    std::vector<uint32_t> buffer(source);
+    std::vector<uint32_t> copy(bins);
+
+    std::printf("%zu bins (%.1f MB)\n", bins, bins * 4 / 1e6);
+    std::printf("%-8s %8.2f GB/s\n", "memcpy", gigabytes_per_second(bins * 4, rounds, [&] {
+        memcpy(copy.data(), buffer.data(), bins * 4);
+    }));
+
+    int failures = 0;
+    size_t count = 0;
+    const byteswap::KernelInfo* table = byteswap::kernels(count);
+    for (size_t k = 0; k < count; ++k) {
+        if (!table[k].supported) {
+            std::printf("%-8s unsupported on this CPU\n", table[k].name);
+            continue;
+        }
+        buffer = source;
+        table[k].kernel(buffer.data(), bins);
+        bool ok = buffer == expected && byteswap::self_check(table[k].kernel);
+        failures += ok ? 0 : 1;
+
+        double rate = gigabytes_per_second(bins * 4, rounds, [&] {
+            table[k].kernel(buffer.data(), bins);
+        });
+        std::printf("%-8s %8.2f GB/s  %s\n", table[k].name, rate, ok ? "ok" : "MISMATCH");
+    }
+    return failures == 0 ? 0 : 1;
+}
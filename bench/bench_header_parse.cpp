@@ -0,0 +1,124 @@
+/**
+ * @file bench_header_parse.cpp
+ * @brief Headers parsed per second: fast in-place parser vs nlohmann/json
+ *
+ * First checks that both parsers agree on a set of regular and unusual
+ * headers, then times each over a batch of realistic header lines.
+ *
+ * Usage: bench_header_parse [headers] [rounds]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../tpx3_header_parser.h"
+
+namespace {
+
+bool same(const FrameHeader& a, const FrameHeader& b) {
+    return a.frame_number == b.frame_number && a.bin_size == b.bin_size &&
+           a.bin_width == b.bin_width && a.bin_offset == b.bin_offset &&
+           a.data_size == b.data_size;
+}
+
+/**
+ * @brief Compare parse_frame_header (fast path first) with the JSON-only path
+ * @return Number of disagreements
+ */
+int check_agreement() {
+    const std::vector<std::string> lines = {
+        "{\"frameNumber\":59,\"binSize\":10,\"binWidth\":384000,\"binOffset\":0,\"dataSize\":40,\"countSum\":7380}",
+        "{\"frameNumber\":0,\"binSize\":1,\"binWidth\":1,\"binOffset\":-5}",
+        "{ \"frameNumber\" : 7 , \"binSize\" : 2 , \"binWidth\" : 3 , \"binOffset\" : 4 }\r",
+        "{\"binOffset\":4,\"binWidth\":3,\"binSize\":2,\"frameNumber\":7,\"dataSize\":8}",
+        "{\"frameNumber\":1,\"binSize\":2,\"binWidth\":3,\"binOffset\":4,\"extra\":\"x\"}",
+        "{\"frameNumber\":1.0,\"binSize\":2,\"binWidth\":3,\"binOffset\":4}",
+        "{\"frameNumber\":1e3,\"binSize\":2,\"binWidth\":3,\"binOffset\":4}",
+        "{\"frameNumber\":01,\"binSize\":2,\"binWidth\":3,\"binOffset\":4}",
+        "{\"frameNumber\":1,\"binSize\":2,\"binWidth\":3}",
+        "{\"frameNumber\":1,\"binSize\":2,\"binWidth\":3,\"binOffset\":4}garbage",
+        "{\"frameNumber\":1,\"binSize\":2,\"binWidth\":3,\"binOffset\":4,}",
+        "{\"frameNumber\":1,\"binSize\":2,\"binWidth\":3,\"binOffset\":4,\"dataSize\":12}",
+        "{\"frameNumber\":1,\"binSize\":-2,\"binWidth\":3,\"binOffset\":4}",
+        "{\"frame\\u004Eumber\":1,\"binSize\":2,\"binWidth\":3,\"binOffset\":4}",
+        "{\"frameNumber\":",
+        "",
+    };
+
+    int mismatches = 0;
+    for (const auto& line : lines) {
+        FrameHeader fast, reference;
+        std::string fast_error, reference_error;
+        bool fast_ok = parse_frame_header(line.data(), line.data() + line.size(), fast, fast_error);
+
+        // Reference: JSON only, followed by the same validation
+        bool reference_ok = parse_frame_header_json(line.data(), line.data() + line.size(),
+                                                    reference, reference_error) &&
+            reference.bin_size >= 0 && reference.bin_size <= MAX_FRAME_BINS &&
+            (reference.data_size < 0 ||
+             reference.data_size == static_cast<long long>(reference.bin_size) * 4);
+
+        if (fast_ok != reference_ok || (fast_ok && !same(fast, reference))) {
+            std::printf("MISMATCH on %s\n", line.c_str());
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+template <typename Parse>
+double headers_per_second(const std::vector<std::string>& lines, int rounds, Parse parse) {
+    long long checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const auto& line : lines) {
+            FrameHeader header;
+            if (parse(line.data(), line.data() + line.size(), header)) {
+                checksum += header.frame_number;
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (checksum == 42) {
+        std::printf(" ");  // Keep the loop observable
+    }
+    return static_cast<double>(lines.size()) * rounds / seconds;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? std::atoi(argv[1]) : 10000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 100;
+    if (count <= 0 || rounds <= 0) {
+        std::fprintf(stderr, "Usage: %s [headers] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    int mismatches = check_agreement();
+    std::printf("Agreement check: %s\n", mismatches == 0 ? "ok" : "FAILED");
+
+    std::vector<std::string> lines;
+    for (int i = 0; i < count; ++i) {
+        int bins = 10 + i % 3000;
+        lines.push_back("{\"frameNumber\":" + std::to_string(i) + ",\"binSize\":" +
+                        std::to_string(bins) + ",\"binWidth\":384000,\"binOffset\":0,\"dataSize\":" +
+                        std::to_string(bins * 4) + ",\"countSum\":" + std::to_string(i * 37) + "}");
+    }
+
+    double fast = headers_per_second(lines, rounds, [](const char* b, const char* e, FrameHeader& h) {
+        return parse_frame_header_fast(b, e, h);
+    });
+    double json = headers_per_second(lines, rounds, [](const char* b, const char* e, FrameHeader& h) {
+        std::string error;
+        return parse_frame_header_json(b, e, h, error);
+    });
+
+    std::printf("fast parser:    %12.0f headers/s\n", fast);
+    std::printf("nlohmann/json:  %12.0f headers/s\n", json);
+    std::printf("speedup:        %12.1fx\n", fast / json);
+    return mismatches == 0 ? 0 : 1;
+}
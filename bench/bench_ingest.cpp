@@ -0,0 +1,181 @@
+/**
+ * @file bench_ingest.cpp
+ * @brief Compare the recv and io_uring ingest backends against a loopback producer
+ *
+ * A producer thread serves a pregenerated stream of frames over 127.0.0.1 and
+ * the benchmark drives IngestLoop with each backend in turn, releasing frames
+ * from a consumer thread exactly like the application does.
+ *
+ * Usage: bench_ingest [frames] [bins] [header_bytes_per_send]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "../tpx3_frame_pool.h"
+#include "../tpx3_ingest.h"
+#include "../tpx3_spsc_ring.h"
+
+namespace {
+
+constexpr size_t BENCH_QUEUE_CAPACITY = 64;
+
+/**
+ * @brief Build the byte stream a server would send for frame_count frames
+ */
+std::string build_stream(int frame_count, int bins) {
+    std::string stream;
+    std::vector<uint32_t> payload(bins);
+    for (int f = 0; f < frame_count; ++f) {
+        for (int i = 0; i < bins; ++i) {
+            payload[i] = htonl(static_cast<uint32_t>((f + i) % 7));
+        }
+        stream += "{\"frameNumber\":" + std::to_string(f) +
+                  ",\"binSize\":" + std::to_string(bins) +
+                  ",\"binWidth\":384000,\"binOffset\":0,\"dataSize\":" +
+                  std::to_string(bins * 4) + "}\n";
+        stream.append(reinterpret_cast<const char*>(payload.data()), payload.size() * 4);
+    }
+    return stream;
+}
+
+/**
+ * @brief Listen on an ephemeral loopback port and send the stream to one client
+ */
+class LoopbackProducer {
+public:
+    LoopbackProducer(const std::string& stream, size_t chunk) : stream_(stream), chunk_(chunk) {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        int opt = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), len) < 0 ||
+            listen(listen_fd_, 1) < 0 ||
+            getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+            throw std::system_error(errno, std::generic_category(), "loopback listen");
+        }
+        port_ = ntohs(addr.sin_port);
+        thread_ = std::thread([this] { serve(); });
+    }
+
+    ~LoopbackProducer() {
+        thread_.join();
+        close(listen_fd_);
+    }
+
+    int port() const { return port_; }
+
+private:
+    void serve() {
+        int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        size_t sent = 0;
+        while (sent < stream_.size()) {
+            size_t n = std::min(chunk_, stream_.size() - sent);
+            ssize_t r = send(fd, stream_.data() + sent, n, MSG_NOSIGNAL);
+            if (r <= 0) {
+                break;
+            }
+            sent += static_cast<size_t>(r);
+        }
+        close(fd);
+    }
+
+    const std::string& stream_;
+    size_t chunk_;
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::thread thread_;
+};
+
+double thread_cpu_seconds() {
+    rusage usage{};
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+void run_backend(IngestBackend backend, const std::string& stream, int frame_count,
+                 int bins, size_t chunk) {
+    FramePool pool(BENCH_QUEUE_CAPACITY + 2, bins);
+    SpscRing<FrameBuffer*> queue(BENCH_QUEUE_CAPACITY);
+    std::atomic<bool> stop{false};
+    std::atomic<bool> done{false};
+    uint64_t frames = 0;
+
+    std::thread consumer([&] {
+        SpinBackoff backoff;
+        FrameBuffer* frame = nullptr;
+        while (true) {
+            if (queue.try_pop(frame)) {
+                ++frames;
+                pool.release(frame);
+                backoff.reset();
+            } else if (done.load(std::memory_order_acquire)) {
+                if (queue.empty()) {
+                    break;
+                }
+            } else {
+                backoff.pause();
+            }
+        }
+    });
+
+    LoopbackProducer producer(stream, chunk);
+    ReconnectPolicy policy;
+    policy.enabled = false;
+    IngestLoop ingest(pool, {SourceEndpoint{"127.0.0.1", producer.port()}}, policy,
+                      DEFAULT_RECEIVE_RING_SIZE, backend);
+
+    double cpu_start = thread_cpu_seconds();
+    auto start = std::chrono::steady_clock::now();
+    ingest.run(stop, [&](FrameBuffer* frame) {
+        SpinBackoff backoff;
+        while (!queue.try_push(std::move(frame))) {
+            backoff.pause();
+        }
+    });
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double cpu = thread_cpu_seconds() - cpu_start;
+    done.store(true, std::memory_order_release);
+    consumer.join();
+
+    std::printf("%-9s %8llu frames %9.1f MB/s %10.0f frames/s  cpu %6.3f s  %8llu receive syscalls%s\n",
+                backend_name(ingest.backend()), static_cast<unsigned long long>(frames),
+                stream.size() / elapsed / 1e6, frames / elapsed, cpu,
+                static_cast<unsigned long long>(ingest.receive_syscalls()),
+                frames == static_cast<uint64_t>(frame_count) ? "" : "  (INCOMPLETE)");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int frame_count = argc > 1 ? std::atoi(argv[1]) : 20000;
+    int bins = argc > 2 ? std::atoi(argv[2]) : 1000;
+    size_t chunk = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1 << 20;
+    if (frame_count <= 0 || bins <= 0 || chunk == 0) {
+        std::fprintf(stderr, "Usage: %s [frames] [bins] [bytes_per_send]\n", argv[0]);
+        return 1;
+    }
+
+    std::string stream = build_stream(frame_count, bins);
+    std::printf("Stream: %d frames x %d bins, %.1f MB, %zu bytes per send\n",
+                frame_count, bins, stream.size() / 1e6, chunk);
+
+    run_backend(IngestBackend::RECV, stream, frame_count, bins, chunk);
+    run_backend(IngestBackend::IO_URING, stream, frame_count, bins, chunk);
+    return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file bench_large_histogram.cpp
+ * @brief Large running sums: contiguous vector vs huge-page chunks, serial vs parallel
+ *
+ * Adds the same wire payload into a RunningSum on VectorStorage (one
+ * contiguous allocation) and on ChunkedStorage, with and without a
+ * WorkerPool. Every variant must end up with the same sum.
+ *
+ * Usage: bench_large_histogram [bins] [rounds] [threads]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "../tpx3_histogram_data.h"
+
+namespace {
+
+template <typename Histogram>
+bool same_counts(const Histogram& histogram, const std::vector<uint64_t>& expected) {
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (histogram.value(i) != expected[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Histogram>
+bool run(const char* name, std::shared_ptr<const BinAxis> axis, const std::vector<uint32_t>& wire,
+         int rounds, WorkerPool* workers, const std::vector<uint64_t>& expected) {
+    Histogram histogram(axis);
+    size_t bins = wire.size();
+    histogram.add_values_be32(wire.data(), bins, workers);  // Fault in every page
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        histogram.add_values_be32(wire.data(), bins, workers);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    bool ok = same_counts(histogram, expected);
+    std::printf("%-26s %8.2f Gbins/s  %zu chunk(s)  %s\n", name,
+                static_cast<double>(bins) * rounds / seconds / 1e9, histogram.chunk_count(),
+                ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t bins = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+    size_t threads = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : default_worker_threads();
+    if (bins == 0 || rounds <= 0 || threads == 0) {
+        std::fprintf(stderr, "Usage: %s [bins] [rounds] [threads]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<uint32_t> wire(bins);
+    std::vector<uint64_t> expected(bins);
+    for (size_t i = 0; i < bins; ++i) {
+        uint32_t count = static_cast<uint32_t>(i % 1000);
+        wire[i] = __builtin_bswap32(count);
+        expected[i] = uint64_t{count} * (rounds + 1);
+    }
+
+    auto axis = std::make_shared<const BinAxis>(bins, 384000, 0);
+    WorkerPool pool(threads);
+    using VectorSum = HistogramData<uint64_t, double, VectorStorage<uint64_t>>;
+
+    std::printf("%zu bins (%zu MB running sum), %s kernel, %zu thread(s)\n", bins,
+                bins * sizeof(uint64_t) >> 20, accumulate_kernel_name(), pool.thread_count());
+
+    bool ok = true;
+    ok &= run<VectorSum>("vector", axis, wire, rounds, nullptr, expected);
+    ok &= run<RunningSum>("chunked", axis, wire, rounds, nullptr, expected);
+    ok &= run<RunningSum>("chunked, worker pool", axis, wire, rounds, &pool, expected);
+
+    RunningSum probe(axis);
+    std::printf("%zu of %zu chunks on reserved huge pages (the rest use THP)\n",
+                probe.storage().explicit_huge_pages(), probe.chunk_count());
+    return ok ? 0 : 1;
+}
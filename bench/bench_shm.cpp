@@ -0,0 +1,141 @@
+/**
+ * @file bench_shm.cpp
+ * @brief Shared-memory live histogram: publish cost and publish-to-reader latency
+ *
+ * A publisher thread writes snapshots into a ShmPublisher segment at a
+ * fixed rate, every bin of snapshot g holding g. Reader threads open the
+ * segment by name, poll the sequence and read each new snapshot in place
+ * through the seqlock, checking that every bin holds the same value (a torn
+ * read would mix two snapshots). Reports the publish time per snapshot and
+ * the latency from the end of a publish to a reader holding a consistent copy.
+ *
+ * Usage: bench_shm [bins] [snapshots] [rate_hz] [readers]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "../tpx3_shm_segment.h"
+
+namespace {
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct ReaderResult {
+    std::vector<int64_t> latencies_ns;
+    uint64_t retries = 0;
+    uint64_t torn = 0;      // Snapshots accepted although their bins disagree (must stay 0)
+};
+
+void reader_loop(const std::string& name, uint64_t last_frames, ReaderResult& result) {
+    ShmReader reader(name);
+    uint64_t seen = 0;
+    std::vector<uint64_t> copy;
+    while (true) {
+        if (reader.sequence() == seen) {
+            std::this_thread::yield();
+            continue;
+        }
+        bool consistent = true;
+        ShmReader::Snapshot snapshot;
+        bool ok = reader.read_with([&](const ShmReader::Snapshot& current, const uint64_t* counts) {
+            snapshot = current;
+            copy.assign(counts, counts + current.axis.bin_count());
+        });
+        if (!ok) {
+            continue;
+        }
+        int64_t latency = now_ns() - snapshot.publish_ns;
+        for (uint64_t value : copy) {
+            consistent &= value == snapshot.frames;
+        }
+        result.torn += consistent ? 0 : 1;
+        result.retries += snapshot.retries;
+        result.latencies_ns.push_back(latency);
+        seen = snapshot.sequence;
+        if (snapshot.frames == last_frames) {
+            return;
+        }
+    }
+}
+
+double percentile_us(std::vector<int64_t> values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    return values[index] / 1e3;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t bins = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    uint64_t snapshots = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 500;
+    double rate = argc > 3 ? std::atof(argv[3]) : 200.0;
+    int readers = argc > 4 ? std::atoi(argv[4]) : 2;
+    if (bins == 0 || snapshots == 0 || rate <= 0.0 || readers < 1) {
+        std::fprintf(stderr, "Usage: %s [bins] [snapshots] [rate_hz] [readers]\n", argv[0]);
+        return 1;
+    }
+
+    std::string name = "/tpx3-bench-shm-" + std::to_string(::getpid());
+    ShmPublisher publisher(name);
+    BinAxis axis(bins, 384000, 0);
+    publisher.publish(axis, 0, [bins](uint64_t* counts) { std::fill(counts, counts + bins, 0); });
+
+    std::vector<ReaderResult> results(readers);
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back(reader_loop, name, snapshots, std::ref(results[r]));
+    }
+
+    std::vector<int64_t> publish_ns;
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / rate));
+    auto next = std::chrono::steady_clock::now();
+    for (uint64_t g = 1; g <= snapshots; ++g) {
+        std::this_thread::sleep_until(next);
+        next += period;
+        int64_t start = now_ns();
+        publisher.publish(axis, g, [bins, g](uint64_t* counts) { std::fill(counts, counts + bins, g); });
+        publish_ns.push_back(now_ns() - start);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    double publish_mean = 0.0;
+    for (int64_t ns : publish_ns) {
+        publish_mean += ns;
+    }
+    publish_mean /= static_cast<double>(publish_ns.size());
+    std::printf("%zu bins, %llu snapshots at %.0f Hz, %d reader(s)\n", bins,
+                static_cast<unsigned long long>(snapshots), rate, readers);
+    std::printf("  publish        %9.1f us mean  %8.2f GB/s  p99 %9.1f us\n", publish_mean / 1e3,
+                bins * sizeof(uint64_t) / publish_mean, percentile_us(publish_ns, 0.99));
+
+    int failures = 0;
+    for (int r = 0; r < readers; ++r) {
+        const ReaderResult& result = results[r];
+        std::printf("  reader %d       %zu snapshots seen, latency p50 %9.1f us  p99 %9.1f us  max %9.1f us, "
+                    "%llu retries, %llu torn\n", r, result.latencies_ns.size(),
+                    percentile_us(result.latencies_ns, 0.5), percentile_us(result.latencies_ns, 0.99),
+                    percentile_us(result.latencies_ns, 1.0), static_cast<unsigned long long>(result.retries),
+                    static_cast<unsigned long long>(result.torn));
+        failures += result.torn > 0 ? 1 : 0;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file bench_staging.cpp
+ * @brief 32-bit staging sums vs widening every frame into the 64-bit running sum
+ *
+ * Streams low-count frames into a running sum far larger than the caches,
+ * once through the fused 64-bit accumulate kernel and once through
+ * StagedSum, including its headroom-driven flushes and a final snapshot.
+ * Both must produce the same sum. A second pass with counts up to 2^30
+ * checks that StagedSum falls back to the 64-bit path instead of flushing
+ * every few frames (the carry path is covered by the kernel self-checks).
+ *
+ * Usage: bench_staging [bins] [frames]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "../tpx3_staged_sum.h"
+
+namespace {
+
+std::vector<uint32_t> make_frame(size_t bins, uint32_t max_count, uint32_t seed) {
+    std::vector<uint32_t> wire(bins);
+    uint32_t state = seed;
+    for (size_t i = 0; i < bins; ++i) {
+        state = state * 1664525u + 1013904223u;
+        wire[i] = __builtin_bswap32(static_cast<uint32_t>((uint64_t{state} * (uint64_t{max_count} + 1)) >> 32));
+    }
+    return wire;
+}
+
+bool same_counts(const RunningSum& a, const RunningSum& b) {
+    for (size_t i = 0; i < a.get_bin_size(); ++i) {
+        if (a.value(i) != b.value(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Run both paths over the same frames
+ * @return true if the sums agree
+ */
+bool compare(const char* label, size_t bins, int frames, uint32_t max_count) {
+    auto axis = std::make_shared<const BinAxis>(bins, 384000, 0);
+    std::vector<std::vector<uint32_t>> wire;
+    for (uint32_t seed = 1; seed <= 4; ++seed) {
+        wire.push_back(make_frame(bins, max_count, seed));
+    }
+
+    RunningSum direct(axis);
+    direct.add_values_be32(wire[0].data(), bins);  // Fault in every page
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 1; f < frames; ++f) {
+        direct.add_values_be32(wire[f % wire.size()].data(), bins);
+    }
+    double direct_seconds = seconds_since(start);
+
+    StagedSum staged(axis);
+    staged.add_be32(wire[0].data(), bins);
+    start = std::chrono::steady_clock::now();
+    for (int f = 1; f < frames; ++f) {
+        staged.add_be32(wire[f % wire.size()].data(), bins);
+    }
+    const RunningSum& snapshot = staged.snapshot();
+    double staged_seconds = seconds_since(start);
+
+    bool ok = same_counts(direct, snapshot);
+    double bin_updates = static_cast<double>(bins) * (frames - 1);
+    std::printf("%s\n", label);
+    std::printf("  64-bit fused (%s)   %8.2f Gbins/s  %6.2f GB/s of sum traffic\n",
+                accumulate_kernel_name(), bin_updates / direct_seconds / 1e9,
+                bin_updates * 2 * sizeof(uint64_t) / direct_seconds / 1e9);
+    std::printf("  32-bit staged (%s)  %8.2f Gbins/s  %6.2f GB/s of sum traffic  %s\n",
+                stage_kernel_name(), bin_updates / staged_seconds / 1e9,
+                bin_updates * 2 * sizeof(uint32_t) / staged_seconds / 1e9, ok ? "ok" : "MISMATCH");
+    std::printf("  %llu flushes, %llu carries, %llu frames bypassed staging, speedup %.2fx\n",
+                static_cast<unsigned long long>(staged.flushes()),
+                static_cast<unsigned long long>(staged.carries()),
+                static_cast<unsigned long long>(staged.direct_frames()), direct_seconds / staged_seconds);
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t bins = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4000000;
+    int frames = argc > 2 ? std::atoi(argv[2]) : 100;
+    if (bins == 0 || frames < 2) {
+        std::fprintf(stderr, "Usage: %s [bins] [frames]\n", argv[0]);
+        return 1;
+    }
+
+    int failures = 0;
+    size_t count = 0;
+    const accumulate::StageKernelInfo* table = accumulate::stage_kernels(count);
+    for (size_t k = 0; k < count; ++k) {
+        if (table[k].supported && !accumulate::stage_self_check(table[k].kernel)) {
+            std::printf("staging kernel %s: MISMATCH\n", table[k].name);
+            ++failures;
+        }
+    }
+
+    std::printf("%zu bins, %d frames\n", bins, frames);
+    failures += compare("Low counts (0-15 per bin)", bins, frames, 15) ? 0 : 1;
+    failures += compare("High counts (up to 2^30 per bin)", bins, frames, 1u << 30) ? 0 : 1;
+    return failures == 0 ? 0 : 1;
+}
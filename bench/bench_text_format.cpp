@@ -0,0 +1,129 @@
+/**
+ * @file bench_text_format.cpp
+ * @brief Histogram text output: iostream formatting vs std::to_chars into one buffer
+ *
+ * Renders the same histogram through the original std::scientific /
+ * std::setprecision(9) stream code and through text_format::format_histogram,
+ * once with 64-bit integer counts (running sum) and once with double counts
+ * (decayed sum). Both paths must produce identical bytes. A few extreme
+ * values (0, UINT64_MAX, subnormals, negative edges) are checked first.
+ *
+ * Usage: bench_text_format [bins] [rounds]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../tpx3_text_format.h"
+
+namespace {
+
+/**
+ * @brief The original writer, rendered to a string instead of a file
+ */
+template <typename CountAt>
+std::string format_iostream(const BinAxis& axis, const CountAt& count_at) {
+    std::ostringstream file;
+    file << "# Time of Flight Histogram Data\n";
+    file << "# Bins: " << axis.bin_count() << "\n";
+    file << "#\n";
+
+    for (size_t i = 0; i < axis.bin_count(); ++i) {
+        file << std::scientific << std::setprecision(9)
+             << axis.edge(i) << "\t"
+             << count_at(i) << "\n";
+    }
+
+    file << std::scientific << std::setprecision(9)
+         << axis.edge(axis.bin_count()) << "\n";
+    return file.str();
+}
+
+template <typename CountAt>
+bool same_output(const BinAxis& axis, const CountAt& count_at) {
+    std::vector<char> buffer;
+    size_t length = text_format::format_histogram(buffer, axis, count_at);
+    return format_iostream(axis, count_at) == std::string(buffer.data(), length);
+}
+
+bool check_extremes() {
+    const uint64_t integers[] = {0, 1, 9, 10, 4294967295u, 4294967296u, std::numeric_limits<uint64_t>::max()};
+    const double doubles[] = {0.0, -0.0, 1.0, 0.1, 9.9999999995, 1e-320, 4.9e-324, 1.7976931348623157e308,
+                              -2.5e-12, 123456789012345.0};
+    BinAxis integer_axis(sizeof(integers) / sizeof(integers[0]), 384000, -1000000);
+    BinAxis double_axis(sizeof(doubles) / sizeof(doubles[0]), 7, -3);
+    return same_output(integer_axis, [&](size_t i) { return integers[i]; }) &&
+           same_output(double_axis, [&](size_t i) { return doubles[i]; });
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Time both paths over the same histogram
+ * @return true if they produce the same bytes
+ */
+template <typename CountAt>
+bool compare(const char* label, const BinAxis& axis, const CountAt& count_at, int rounds) {
+    std::string reference;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        reference = format_iostream(axis, count_at);
+    }
+    double stream_seconds = seconds_since(start);
+
+    std::vector<char> buffer;
+    size_t length = 0;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        length = text_format::format_histogram(buffer, axis, count_at);
+    }
+    double chars_seconds = seconds_since(start);
+
+    bool ok = reference == std::string(buffer.data(), length);
+    double bytes = static_cast<double>(length) * rounds;
+    std::printf("%s (%.1f MB per file)\n", label, length / 1e6);
+    std::printf("  iostream   %8.1f MB/s\n", bytes / stream_seconds / 1e6);
+    std::printf("  to_chars   %8.1f MB/s  %s, speedup %.2fx\n", bytes / chars_seconds / 1e6,
+                ok ? "identical" : "MISMATCH", stream_seconds / chars_seconds);
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t bins = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (bins == 0 || rounds < 1) {
+        std::fprintf(stderr, "Usage: %s [bins] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    int failures = 0;
+    if (!check_extremes()) {
+        std::printf("extreme values: MISMATCH\n");
+        ++failures;
+    }
+
+    BinAxis axis(bins, 384000, 0);
+    std::vector<uint64_t> counts(bins);
+    std::vector<double> decayed(bins);
+    uint64_t state = 1;
+    for (size_t i = 0; i < bins; ++i) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        counts[i] = state >> (state % 48 + 16);
+        decayed[i] = static_cast<double>(counts[i]) / 3.0;
+    }
+
+    std::printf("%zu bins, %d rounds\n", bins, rounds);
+    failures += compare("64-bit counts", axis, [&](size_t i) { return counts[i]; }, rounds) ? 0 : 1;
+    failures += compare("Double counts", axis, [&](size_t i) { return decayed[i]; }, rounds) ? 0 : 1;
+    return failures == 0 ? 0 : 1;
+}
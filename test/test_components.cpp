@@ -0,0 +1,382 @@
+/**
+ * @file test_components.cpp
+ * @brief Checks of the header-only components that need no server
+ *
+ * Each check prints one line and the program exits non-zero if any failed.
+ * Run by `make test` before the end-to-end script.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "../tpx3_decay.h"
+#include "../tpx3_frame_pool.h"
+#include "../tpx3_histogram_data.h"
+#include "../tpx3_rebin.h"
+#include "../tpx3_shm_segment.h"
+#include "../tpx3_snapshot_file.h"
+#include "../tpx3_stream_framer.h"
+#include "../tpx3_worker_pool.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    std::printf("  %-60s %s\n", what.c_str(), ok ? "ok" : "FAILED");
+    failures += ok ? 0 : 1;
+}
+
+std::string frame_header(int frame_number, int bins) {
+    return "{\"frameNumber\":" + std::to_string(frame_number) + ",\"binSize\":" + std::to_string(bins) +
+           ",\"binWidth\":1,\"binOffset\":0,\"dataSize\":" + std::to_string(bins * 4) + "}\n";
+}
+
+/**
+ * @brief Several framers sharing one pool each drop a frame mid-payload
+ */
+void test_frame_pool_resets() {
+    std::printf("Frame pool:\n");
+    const size_t sources = 4;
+    FramePool pool(sources + 2, 16);
+    std::vector<std::unique_ptr<StreamFramer>> framers;
+    for (size_t i = 0; i < sources; ++i) {
+        framers.push_back(std::make_unique<StreamFramer>(pool));
+    }
+    for (int round = 0; round < 3; ++round) {
+        for (auto& framer : framers) {
+            std::string partial = frame_header(round, 16) + std::string(10, '\0');
+            framer->feed(partial.data(), partial.size(), [](FrameBuffer*) {});
+        }
+        size_t partial_frames = 0;
+        for (auto& framer : framers) {
+            partial_frames += framer->reset() ? 1 : 0;
+        }
+        check(partial_frames == sources, "round " + std::to_string(round) + ": every framer held a partial frame");
+    }
+
+    std::vector<FrameBuffer*> acquired;
+    while (FrameBuffer* buffer = pool.try_acquire(16)) {
+        acquired.push_back(buffer);
+    }
+    check(acquired.size() == pool.buffer_count(), "all " + std::to_string(pool.buffer_count()) +
+          " buffers can be acquired after the resets");
+    for (FrameBuffer* buffer : acquired) {
+        pool.release(buffer);
+    }
+}
+
+/**
+ * @brief Frames that are consumed as they arrive must keep reusing the same buffers
+ */
+void test_frame_pool_reuse() {
+    FramePool pool(64, 16);
+    std::vector<FrameBuffer*> used;
+    FrameBuffer* held = pool.try_acquire(1000);
+    for (int frame = 0; frame < 1000; ++frame) {
+        // One frame queued while the next is received, as when the consumer keeps up
+        FrameBuffer* next = pool.try_acquire(1000);
+        pool.release(held);
+        held = next;
+        if (std::find(used.begin(), used.end(), next) == used.end()) {
+            used.push_back(next);
+        }
+    }
+    pool.release(held);
+    check(used.size() <= 3 && pool.regrowths() <= 3,
+          "1000 frames of 1000 bins used " + std::to_string(used.size()) + " buffers, " +
+          std::to_string(pool.regrowths()) + " regrowths");
+}
+
+/**
+ * @brief Narrow count types must saturate, including across chunks that do not line up
+ */
+void test_count_types() {
+    std::printf("Count types:\n");
+    auto axis = std::make_shared<const BinAxis>(4, 10, -5);
+    std::vector<double> edges = axis->materialize();
+    check(edges.size() == 5 && edges[0] == axis->edge(0) && edges[4] == axis->edge(4),
+          "materialize() returns all 5 edges");
+
+    const uint32_t counts[] = {1, 65534, 70000, 0xffffffffu};
+    uint32_t wire[4];
+    for (size_t i = 0; i < 4; ++i) {
+        wire[i] = __builtin_bswap32(counts[i]);
+    }
+    HistogramData<uint16_t> narrow(axis);
+    narrow.set_value(1, 1);
+    bool capped = narrow.add_values_be32(wire, 4);
+    check(capped && narrow.value(0) == 1 && narrow.value(1) == 65535 && narrow.value(2) == 65535 &&
+          narrow.value(3) == 65535, "uint16_t: add_values_be32 saturates at 65535");
+    FrameHistogram frame(axis);
+    frame.set_value(0, 0xffffffffu);
+    capped = frame.add_values_be32(wire, 4);
+    check(capped && frame.value(0) == 0xffffffffu && frame.value(1) == 65534 && frame.value(3) == 0xffffffffu,
+          "uint32_t: add_values_be32 saturates at 2^32 - 1");
+    const uint32_t ones[] = {__builtin_bswap32(1), __builtin_bswap32(1), __builtin_bswap32(1), __builtin_bswap32(1)};
+    HistogramData<uint16_t> small(axis);
+    small.add_values_be32(ones, 4);
+    check(!small.add_values_be32(ones, 4) && small.value(0) == 2, "uint16_t: no overflow reported below the maximum");
+
+    // Single chunk: uint16_t into uint32_t and uint16_t
+    capped = frame.add_histogram(narrow);
+    check(capped && frame.value(0) == 0xffffffffu && frame.value(1) == 65534 + 65535 &&
+          frame.value(2) == 70000 + 65535, "uint32_t += uint16_t saturates only the full bin");
+    capped = narrow.add_histogram(small);
+    check(capped && narrow.value(0) == 3 && narrow.value(1) == 65535, "uint16_t += uint16_t saturates at 65535");
+
+    // Chunked: 2 MB chunks hold 1048576 uint16_t but 524288 uint32_t, so the boundaries differ
+    const size_t bins = 1500000;
+    auto wide_axis = std::make_shared<const BinAxis>(bins, 1, 0);
+    HistogramData<uint16_t, double, ChunkedStorage<uint16_t>> source(wide_axis);
+    HistogramData<uint32_t, double, ChunkedStorage<uint32_t>> sum(wide_axis);
+    for (size_t i = 0; i < bins; ++i) {
+        source.set_value(i, static_cast<uint16_t>(i % 1000));
+        sum.set_value(i, static_cast<uint32_t>(i));
+    }
+    const size_t full[] = {524287, 524288, 1048575, 1048576, bins - 1};
+    for (size_t i : full) {
+        source.set_value(i, 65535);
+        sum.set_value(i, 0xffffffffu - 10);
+    }
+    WorkerPool workers(2);
+    capped = sum.add_histogram(source, &workers);
+    bool exact = true;
+    for (size_t i = 0; i < bins; ++i) {
+        bool is_full = std::find(std::begin(full), std::end(full), i) != std::end(full);
+        exact &= sum.value(i) == (is_full ? 0xffffffffu : i + i % 1000);
+    }
+    check(source.chunk_count() == 2 && sum.chunk_count() == 3 && capped && exact,
+          "chunked uint32_t += uint16_t across misaligned chunks");
+}
+
+/**
+ * @brief Back-to-back runs of varying size must each run every task exactly once
+ */
+void test_worker_pool_runs() {
+    std::printf("Worker pool:\n");
+    WorkerPool pool(4);
+    std::vector<std::atomic<int>> runs(64);
+    bool exact = true;
+    for (int round = 0; round < 5000; ++round) {
+        size_t count = 2 + round % 63;
+        for (size_t i = 0; i < count; ++i) {
+            runs[i].store(0, std::memory_order_relaxed);
+        }
+        pool.run(count, [&runs](size_t i) { runs[i].fetch_add(1, std::memory_order_relaxed); });
+        for (size_t i = 0; i < count; ++i) {
+            exact &= runs[i].load(std::memory_order_relaxed) == 1;
+        }
+    }
+    check(exact, "5000 runs of 2..64 tasks each run every task once");
+}
+
+uint64_t total(const HistogramData<uint64_t>& sum) {
+    uint64_t result = 0;
+    for (size_t i = 0; i < sum.get_bin_size(); ++i) {
+        result += sum.value(i);
+    }
+    return result;
+}
+
+/**
+ * @brief Overlap weights, conservation and dropped counts of the rebinner
+ */
+void test_rebin() {
+    std::printf("Rebinning:\n");
+    auto master = std::make_shared<const BinAxis>(6, 20, 0);  // [0, 120) ticks
+
+    // Frame bins of 40 ticks from 10 split 1/4, 1/2, 1/4; the last one sticks out by 10 ticks
+    RebinTable quarters(BinAxis(3, 40, 10), *master);
+    const uint64_t quarter = RebinTable::WEIGHT_ONE / 4;
+    const std::vector<std::vector<RebinTable::Entry>> expected = {
+        {{0, quarter}, {1, 2 * quarter}, {2, quarter}},
+        {{2, quarter}, {3, 2 * quarter}, {4, quarter}},
+        {{4, quarter}, {5, 2 * quarter}},
+    };
+    bool weights = quarters.frame_bins() == expected.size();
+    for (size_t i = 0; weights && i < expected.size(); ++i) {
+        weights = static_cast<size_t>(quarters.end(i) - quarters.begin(i)) == expected[i].size();
+        for (size_t k = 0; weights && k < expected[i].size(); ++k) {
+            const RebinTable::Entry& entry = quarters.begin(i)[k];
+            weights = entry.master_bin == expected[i][k].master_bin && entry.weight == expected[i][k].weight;
+        }
+    }
+    check(weights, "overlap weights of a 40-tick grid on a 20-tick grid");
+    check(quarters.partial_bins() == 1 && quarters.dropped_bins() == 0 && !quarters.disjoint(),
+          "one bin partly outside the master grid");
+
+    Rebinner rebinner(master);
+    HistogramData<uint64_t> sum(master);
+    rebinner.add(sum, rebinner.table(3, 40, 10), [](size_t) { return uint64_t{4}; });
+    const uint64_t exact[] = {1, 2, 2, 2, 2, 2};
+    bool exact_counts = true;
+    for (size_t i = 0; i < 6; ++i) {
+        exact_counts &= sum.value(i) == exact[i];
+    }
+    check(exact_counts && rebinner.dropped_counts() == 1, "counts of one frame, 1 of 12 dropped");
+
+    // Thirds do not add up exactly in fixed point; the residues must carry the remainder
+    Rebinner thirds(master);
+    HistogramData<uint64_t> thirds_sum(master);
+    const uint64_t frames = 3000;
+    for (uint64_t f = 0; f < frames; ++f) {
+        thirds.add(thirds_sum, thirds.table(4, 30, 10), [](size_t) { return uint64_t{3}; });
+    }
+    uint64_t kept = total(thirds_sum);
+    check(kept <= 11 * frames && kept + master->bin_count() >= 11 * frames,
+          "3000 frames on thirds: " + std::to_string(kept) + " of " + std::to_string(11 * frames) +
+          " counts kept");
+    check(thirds.dropped_counts() == frames && thirds.frames_rebinned() == frames,
+          "3000 frames on thirds: " + std::to_string(thirds.dropped_counts()) + " counts dropped");
+
+    check(!rebinner.can_rebin(0) && !rebinner.can_rebin(-20) && rebinner.can_rebin(1),
+          "frames with a non-positive binWidth cannot be rebinned");
+    Rebinner flat(std::make_shared<const BinAxis>(6, 0, 0));
+    check(!flat.can_rebin(20), "nothing can be rebinned onto a non-positive binWidth");
+}
+
+/**
+ * @brief The decayed sum must follow sum = sum * alpha + frame, also across rescales
+ */
+void test_decayed_sum() {
+    std::printf("Decayed sum:\n");
+    const size_t bins = 8;
+    const double alpha = 0.9;
+    DecayedSum decayed(std::make_shared<const BinAxis>(bins, 1, 0), alpha);
+    std::vector<double> reference(bins, 0.0);
+    std::vector<uint32_t> wire(bins);
+    double worst = 0.0;
+    for (uint32_t frame = 0; frame < 4000; ++frame) {
+        for (size_t i = 0; i < bins; ++i) {
+            uint32_t count = (frame * 7 + static_cast<uint32_t>(i) * 13) % 100 + (i == 0 ? 4000000000u : 0u);
+            wire[i] = __builtin_bswap32(count);
+            reference[i] = reference[i] * alpha + count;
+        }
+        decayed.add_be32(wire.data(), bins);
+        for (size_t i = 0; i < bins; ++i) {
+            worst = std::max(worst, std::fabs(decayed.value(i) - reference[i]) / reference[i]);
+        }
+    }
+    char error[32];
+    std::snprintf(error, sizeof(error), "%.1e", worst);
+    check(worst < 1e-12, "4000 frames match the recurrence (relative error " + std::string(error) + ")");
+    check(decayed.rescales() > 0, "the scale was folded back " + std::to_string(decayed.rescales()) + " time(s)");
+}
+
+std::vector<char> read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+/**
+ * @brief .tpx3h and .npy files written like the checkpoint writer does must read back unchanged
+ */
+void test_snapshot_files() {
+    std::printf("Snapshot files:\n");
+    BinAxis axis(1000, 384000, -12345);
+    std::vector<uint64_t> counts(axis.bin_count());
+    for (size_t i = 0; i < counts.size(); ++i) {
+        counts[i] = i * 0x100000001ull;
+    }
+    std::string base = "/tmp/tpx3-test-" + std::to_string(::getpid());
+
+    BinarySnapshotHeader header = BinarySnapshotHeader::make(axis, 42, 7);
+    check(write_file_atomically(base + ".tpx3h", {as_bytes(&header, 1), as_bytes(counts.data(), counts.size())}),
+          ".tpx3h written");
+    std::vector<char> file = read_file(base + ".tpx3h");
+    bool same = false;
+    try {
+        const BinarySnapshotHeader& read = BinarySnapshotHeader::from_bytes(file.data(), file.size());
+        same = read.bin_count == axis.bin_count() && read.bin_width == axis.bin_width() &&
+               read.bin_offset == axis.bin_offset() && read.clock_period == axis.clock_period() &&
+               read.frames == 42 && read.generation == 7 &&
+               std::memcmp(read.counts(), counts.data(), counts.size() * sizeof(uint64_t)) == 0;
+    } catch (const std::exception& e) {
+        std::printf("  %s\n", e.what());
+    }
+    check(same, ".tpx3h round-trip through from_bytes");
+    bool rejected = false;
+    try {
+        BinarySnapshotHeader::from_bytes(file.data(), file.size() - 8);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    check(rejected, "a truncated .tpx3h is rejected");
+
+    std::string npy = npy_header(counts.size(), "<u8");
+    check(write_file_atomically(base + ".npy", {Span<const char>(npy.data(), npy.size()),
+                                                as_bytes(counts.data(), counts.size())}), ".npy written");
+    file = read_file(base + ".npy");
+    size_t header_length = 10 + (static_cast<unsigned char>(file[8]) | static_cast<unsigned char>(file[9]) << 8);
+    std::string dict(file.data() + 10, header_length - 10);
+    check(std::memcmp(file.data(), "\x93NUMPY\x01\x00", 8) == 0 && header_length % 64 == 0 &&
+          dict.find("'descr': '<u8'") != std::string::npos && dict.find("'shape': (1000,)") != std::string::npos &&
+          dict.back() == '\n', ".npy header: magic, 64-byte aligned, dtype and shape");
+    check(file.size() == header_length + counts.size() * sizeof(uint64_t) &&
+          std::memcmp(file.data() + header_length, counts.data(), counts.size() * sizeof(uint64_t)) == 0,
+          ".npy data follows the header unchanged");
+    std::remove((base + ".tpx3h").c_str());
+    std::remove((base + ".npy").c_str());
+}
+
+/**
+ * @brief A reader must follow the publisher into a larger segment, and a second publisher must not take the name
+ */
+void test_shm_growth() {
+    std::printf("Shared memory:\n");
+    std::string name = "/tpx3-test-" + std::to_string(::getpid());
+    ShmPublisher publisher(name);
+    ShmReader reader(name);
+    ShmReader::Snapshot snapshot;
+    std::vector<uint64_t> counts;
+    check(!reader.read(snapshot, counts), "nothing to read before the first publish");
+
+    publisher.publish(BinAxis(16, 10, 0), 1, [](uint64_t* out) { std::fill(out, out + 16, 1); });
+    bool small = reader.read(snapshot, counts) && counts.size() == 16 && counts[15] == 1 && snapshot.frames == 1;
+    check(small, "16 bins read after the first publish");
+
+    publisher.publish(BinAxis(100000, 10, 0), 2, [](uint64_t* out) { std::fill(out, out + 100000, 2); });
+    bool grown = reader.read(snapshot, counts) && counts.size() == 100000 && counts.front() == 2 &&
+                 counts.back() == 2 && snapshot.frames == 2 && snapshot.axis.bin_count() == 100000;
+    check(grown, "100000 bins read after the segment grew");
+
+    bool refused = false;
+    try {
+        ShmPublisher second(name);
+    } catch (const std::runtime_error&) {
+        refused = true;
+    }
+    check(refused && reader.read(snapshot, counts) && snapshot.frames == 2,
+          "a second publisher cannot take over the name");
+}
+
+} // namespace
+
+int main() {
+    test_frame_pool_resets();
+    test_frame_pool_reuse();
+    test_count_types();
+    test_worker_pool_runs();
+    test_rebin();
+    test_decayed_sum();
+    test_snapshot_files();
+    test_shm_growth();
+    if (failures > 0) {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("All component checks passed\n");
+    return 0;
+}
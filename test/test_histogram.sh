@@ -39,9 +39,200 @@ echo "Note: The program expects a TPX3 server to be running on the specified hos
 echo "      to receive histogram data frames."
 echo
 
+# Write a single-source recording for --replay. Each spec is
+# FRAMES:BINS:WIDTH:OFFSET:COUNT (every bin of every frame holds COUNT), or
+# garbage:TEXT to insert raw bytes between frames.
+write_recording() {
+    python3 - "$@" <<'PYTHON'
+import struct, sys
+out, specs = sys.argv[1], sys.argv[2:]
+stream, frame_number = b"", 0
+for spec in specs:
+    if spec.startswith("garbage:"):
+        stream += spec[len("garbage:"):].encode()
+        continue
+    frames, bins, width, offset, count = map(int, spec.split(":"))
+    for _ in range(frames):
+        header = '{"frameNumber":%d,"binSize":%d,"binWidth":%d,"binOffset":%d,"dataSize":%d}\n' % (
+            frame_number, bins, width, offset, bins * 4)
+        stream += header.encode() + struct.pack(">%dI" % bins, *([count] * bins))
+        frame_number += 1
+label = b"127.0.0.1:8451"
+with open(out, "wb") as f:
+    f.write(b"TPX3RAW1" + struct.pack("<II", 1, 1) + struct.pack("<I", len(label)) + label)
+    for start in range(0, len(stream), 1000):
+        chunk = stream[start:start + 1000]
+        f.write(struct.pack("<QII", start, 0, len(chunk)) + chunk)
+PYTHON
+}
+
+# Sum of the counts in a text histogram
+text_total() {
+    awk '!/^#/ && NF == 2 { sum += $2 } END { print sum }' "$1"
+}
+
 # Test help functionality
 echo "Testing help functionality:"
 ../tpx3_histogram --help
 echo
 
+# End-to-end run against the synthetic server
+if [ -f "../tpx3_mock_server" ]; then
+    echo "Testing end-to-end with tpx3_mock_server:"
+    PORT=18451
+    FRAMES=200
+    BINS=100
+    MEAN=3
+    cd ..
+    ./tpx3_mock_server --port $PORT --bins $BINS --frames $FRAMES --rate 0 \
+        --distribution constant --mean $MEAN --quiet &
+    SERVER_PID=$!
+    sleep 0.5
+    ./tpx3_histogram --port $PORT --no-reconnect --quiet
+    STATUS=$?
+    wait $SERVER_PID
+    cd test
+
+    if [ $STATUS -ne 0 ]; then
+        echo "Error: tpx3_histogram exited with status $STATUS"
+        exit 1
+    fi
+    TOTAL=$(text_total ../data/tof-histogram-running-sum.txt)
+    EXPECTED=$((FRAMES * BINS * MEAN))
+    if [ "$TOTAL" != "$EXPECTED" ]; then
+        echo "Error: running sum holds $TOTAL counts, expected $EXPECTED"
+        exit 1
+    fi
+    echo "Running sum holds $TOTAL counts as expected"
+    echo
+else
+    echo "Skipping end-to-end test: ../tpx3_mock_server not built"
+    echo
+fi
+
+# Replayed recordings: exact, deterministic streams
+if command -v python3 > /dev/null; then
+    TMP=$(mktemp -d)
+    trap 'rm -rf "$TMP"' EXIT
+    cd ..
+
+    echo "Testing a grid change to binWidth 0 (must start a new running sum):"
+    rm -f data/tof-histogram-running-sum*.txt
+    write_recording "$TMP/grid.raw" 20:10:100:0:1 10:10:0:0:2
+    ./tpx3_histogram --replay "$TMP/grid.raw" --quiet > /dev/null || exit 1
+    ARCHIVED=$(text_total data/tof-histogram-running-sum-grid1.txt)
+    TOTAL=$(text_total data/tof-histogram-running-sum.txt)
+    if [ "$ARCHIVED" != "200" ] || [ "$TOTAL" != "200" ]; then
+        echo "Error: expected 200 counts archived and 200 in the new sum, got $ARCHIVED and $TOTAL"
+        exit 1
+    fi
+    echo "Archived sum holds $ARCHIVED counts, new sum $TOTAL"
+    echo
+
+    echo "Testing resynchronization after garbage, a truncated header and an overlong line:"
+    rm -f data/tof-histogram-running-sum*
+    write_recording "$TMP/corrupt.raw" 10:50:100:0:2 $'garbage:not a header\n' 10:50:100:0:2 \
+        'garbage:{"frameNumber":' 10:50:100:0:2 "garbage:$(head -c 5000 /dev/zero | tr '\0' x)" 10:50:100:0:2
+    ./tpx3_histogram --replay "$TMP/corrupt.raw" --quiet --output-formats text,binary > "$TMP/corrupt.log" 2>&1 \
+        || exit 1
+    TOTAL=$(text_total data/tof-histogram-running-sum.txt)
+    if [ "$TOTAL" != "4000" ] || ! grep -q "40 frames, .* 3 resyncs, .* 0 frames lost" "$TMP/corrupt.log"; then
+        echo "Error: expected all 40 frames (4000 counts) after 3 resyncs, got $TOTAL counts:"
+        grep "^Source" "$TMP/corrupt.log"
+        exit 1
+    fi
+    echo "All 40 frames recovered after 3 resyncs ($TOTAL counts)"
+    if [ -f tpx3_snapshot_reader ]; then
+        if ! ./tpx3_snapshot_reader data/tof-histogram-running-sum.tpx3h --text | \
+                cmp -s - data/tof-histogram-running-sum.txt; then
+            echo "Error: tpx3_snapshot_reader --text differs from the text output"
+            exit 1
+        fi
+        echo "tpx3_snapshot_reader --text matches the text output"
+    fi
+    echo
+
+    echo "Testing the decayed sum (alpha 0.5, 30 frames of 4 per bin):"
+    write_recording "$TMP/decay.raw" 30:10:100:0:4
+    ./tpx3_histogram --replay "$TMP/decay.raw" --quiet --decay-alpha 0.5 > /dev/null || exit 1
+    # sum = 4 * (1 - 0.5^30) / (1 - 0.5) in every bin
+    BAD=$(awk '!/^#/ && NF == 2 { d = $2 - 7.99999999255; if (d < -1e-8 || d > 1e-8) bad++ } END { print bad + 0 }' \
+        data/tof-histogram-running-sum-decayed.txt)
+    if [ "$BAD" != "0" ]; then
+        echo "Error: $BAD decayed bins differ from 4 * (1 - 0.5^30) / 0.5"
+        exit 1
+    fi
+    echo "Every decayed bin holds 4 * (1 - 0.5^30) / 0.5"
+    echo
+
+    echo "Testing waterfall row rollover (45 frames, 10 per row, 3 rows kept):"
+    write_recording "$TMP/waterfall.raw" 45:10:100:0:1
+    ./tpx3_histogram --replay "$TMP/waterfall.raw" --quiet --waterfall-frames 10 --waterfall-rows 3 > /dev/null \
+        || exit 1
+    python3 - data/tof-histogram-running-sum-waterfall.bin <<'PYTHON' || exit 1
+import struct, sys
+data = open(sys.argv[1], "rb").read()
+bins, rows, mode = struct.unpack_from("<3I", data, 12)
+infos = [struct.unpack_from("<3q2I", data, 48 + 32 * r) for r in range(rows)]
+counts = struct.unpack_from("<%dI" % (rows * bins), data, 48 + 32 * rows)
+got = [(first, last, frames, counts[r * bins:(r + 1) * bins]) for r, (first, last, _, frames, _) in enumerate(infos)]
+expected = [(20, 29, 10, (10,) * 10), (30, 39, 10, (10,) * 10), (40, 44, 5, (5,) * 10)]
+if (bins, rows, mode) != (10, 3, 0) or got != expected:
+    sys.exit("Error: waterfall holds %s rows %s" % ((bins, rows, mode), [g[:3] for g in got]))
+print("Waterfall keeps rows 20-29, 30-39 and 40-44, oldest first")
+PYTHON
+    # 30000 rows of 4 bytes per bin leave room for 8 bins in 1 MiB; the frames have 10
+    rm -f data/tof-histogram-running-sum-waterfall.bin
+    ./tpx3_histogram --replay "$TMP/waterfall.raw" --quiet --waterfall-frames 10 --waterfall-rows 30000 \
+        --waterfall-max-mb 1 > "$TMP/waterfall.log" 2>&1 || exit 1
+    if ! grep -q "Waterfall disabled: .* 30000 rows x 10 bins" "$TMP/waterfall.log" || \
+            [ -f data/tof-histogram-running-sum-waterfall.bin ] || \
+            [ "$(text_total data/tof-histogram-running-sum.txt)" != "450" ]; then
+        echo "Error: a waterfall above --waterfall-max-mb must be refused without stopping the running sum"
+        exit 1
+    fi
+    echo "A waterfall above --waterfall-max-mb is refused and the running sum continues"
+    echo
+
+    cd test
+else
+    echo "Skipping replay tests: python3 not found"
+    echo
+fi
+
+# Live shared-memory snapshot against the text output of the same run
+if [ -f "../tpx3_mock_server" ] && [ -f "../tpx3_snapshot_reader" ]; then
+    echo "Testing tpx3_snapshot_reader --shm against the text output:"
+    PORT=18452
+    SHM_NAME=tpx3-test-$$
+    cd ..
+    ./tpx3_mock_server --port $PORT --bins 100 --frames 50 --rate 100 --distribution constant --mean 3 --quiet &
+    SERVER_PID=$!
+    sleep 0.5
+    # Keeps running (reconnecting) after the server is done, so the segment stays up
+    ./tpx3_histogram --port $PORT --quiet --shm $SHM_NAME > /dev/null 2>&1 &
+    HISTOGRAM_PID=$!
+    wait $SERVER_PID
+    for _ in $(seq 50); do
+        [ "$(text_total data/tof-histogram-running-sum.txt)" = "15000" ] && break
+        sleep 0.1
+    done
+    sleep 0.2
+    ./tpx3_snapshot_reader --shm $SHM_NAME --text > "${TMPDIR:-/tmp}/$SHM_NAME.txt"
+    STATUS=$?
+    kill -INT $HISTOGRAM_PID
+    wait $HISTOGRAM_PID
+    cmp -s "${TMPDIR:-/tmp}/$SHM_NAME.txt" data/tof-histogram-running-sum.txt
+    SAME=$?
+    rm -f "${TMPDIR:-/tmp}/$SHM_NAME.txt"
+    cd test
+
+    if [ $STATUS -ne 0 ] || [ $SAME -ne 0 ]; then
+        echo "Error: the shared-memory snapshot differs from the text output"
+        exit 1
+    fi
+    echo "Shared-memory snapshot matches the text output"
+    echo
+fi
+
 echo "Test completed successfully!"
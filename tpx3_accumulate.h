@@ -0,0 +1,406 @@
+#ifndef TPX3_ACCUMULATE_H
+#define TPX3_ACCUMULATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include "tpx3_byteswap.h"  // x86 detection and intrinsics
+
+/**
+ * @brief Fused byte-swap, widen and add of a wire payload into a 64-bit running sum
+ *
+ * accumulate_be32() reads big-endian uint32 bin counts straight from the
+ * received buffer, converts and widens them in registers and adds them to the
+ * running sum in a single pass; the payload is never written back. Lanes that
+ * wrap are saturated to UINT64_MAX without a branch, and a sticky vector flag
+ * tells the caller that at least one bin overflowed. The kernel (AVX-512,
+ * AVX2 or scalar) is chosen once from CPUID and verified against the scalar
+ * path before use, like the byte-swap kernels.
+ */
+namespace accumulate {
+
+using Kernel = bool (*)(uint64_t*, const uint32_t*, size_t);
+
+inline bool add_scalar(uint64_t* sum, const uint32_t* wire, size_t count) {
+    bool overflow = false;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t value = sum[i] + __builtin_bswap32(wire[i]);
+        bool wrapped = value < sum[i];
+        overflow |= wrapped;
+        sum[i] = wrapped ? UINT64_MAX : value;
+    }
+    return overflow;
+}
+
+#ifdef TPX3_BYTESWAP_X86
+
+__attribute__((target("avx2")))
+inline bool add_avx2(uint64_t* sum, const uint32_t* wire, size_t count) {
+    const __m256i shuffle = _mm256_set_epi8(
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    // Unsigned 64-bit compare via signed compare on sign-flipped values
+    const __m256i bias = _mm256_set1_epi64x(static_cast<long long>(0x8000000000000000ull));
+    __m256i flags = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i counts = _mm256_shuffle_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wire + i)), shuffle);
+        __m256i low = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(counts));
+        __m256i high = _mm256_cvtepu32_epi64(_mm256_extracti128_si256(counts, 1));
+
+        __m256i* out = reinterpret_cast<__m256i*>(sum + i);
+        __m256i old_low = _mm256_loadu_si256(out);
+        __m256i old_high = _mm256_loadu_si256(out + 1);
+        __m256i new_low = _mm256_add_epi64(old_low, low);
+        __m256i new_high = _mm256_add_epi64(old_high, high);
+
+        // A lane wrapped iff the new value is below the old one
+        __m256i wrap_low = _mm256_cmpgt_epi64(_mm256_xor_si256(old_low, bias),
+                                              _mm256_xor_si256(new_low, bias));
+        __m256i wrap_high = _mm256_cmpgt_epi64(_mm256_xor_si256(old_high, bias),
+                                               _mm256_xor_si256(new_high, bias));
+        _mm256_storeu_si256(out, _mm256_or_si256(new_low, wrap_low));
+        _mm256_storeu_si256(out + 1, _mm256_or_si256(new_high, wrap_high));
+        flags = _mm256_or_si256(flags, _mm256_or_si256(wrap_low, wrap_high));
+    }
+
+    bool overflow = !_mm256_testz_si256(flags, flags);
+    return add_scalar(sum + i, wire + i, count - i) || overflow;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline bool add_avx512(uint64_t* sum, const uint32_t* wire, size_t count) {
+    const __m256i shuffle = _mm256_set_epi8(
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    const __m512i saturated = _mm512_set1_epi64(-1);
+    __mmask8 flags = 0;
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        // Swap each 256-bit half and widen it to eight 64-bit lanes (the maskz
+        // form avoids a GCC 12 -Wmaybe-uninitialized false positive)
+        const __m256i* in = reinterpret_cast<const __m256i*>(wire + i);
+        __m512i low = _mm512_maskz_cvtepu32_epi64(
+            0xff, _mm256_shuffle_epi8(_mm256_loadu_si256(in), shuffle));
+        __m512i high = _mm512_maskz_cvtepu32_epi64(
+            0xff, _mm256_shuffle_epi8(_mm256_loadu_si256(in + 1), shuffle));
+
+        __m512i old_low = _mm512_loadu_si512(sum + i);
+        __m512i old_high = _mm512_loadu_si512(sum + i + 8);
+        __m512i new_low = _mm512_add_epi64(old_low, low);
+        __m512i new_high = _mm512_add_epi64(old_high, high);
+
+        __mmask8 wrap_low = _mm512_cmplt_epu64_mask(new_low, old_low);
+        __mmask8 wrap_high = _mm512_cmplt_epu64_mask(new_high, old_high);
+        _mm512_storeu_si512(sum + i, _mm512_mask_mov_epi64(new_low, wrap_low, saturated));
+        _mm512_storeu_si512(sum + i + 8, _mm512_mask_mov_epi64(new_high, wrap_high, saturated));
+        flags |= wrap_low | wrap_high;
+    }
+
+    return add_scalar(sum + i, wire + i, count - i) || flags != 0;
+}
+
+#endif // TPX3_BYTESWAP_X86
+
+struct KernelInfo {
+    const char* name;
+    Kernel kernel;
+    bool supported;
+};
+
+/**
+ * @brief All kernels compiled in, widest first, with CPU support flags
+ */
+inline const KernelInfo* kernels(size_t& count) {
+    static const KernelInfo table[] = {
+#ifdef TPX3_BYTESWAP_X86
+        {"avx512", add_avx512,
+         __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")},
+        {"avx2", add_avx2, static_cast<bool>(__builtin_cpu_supports("avx2"))},
+#endif
+        {"scalar", add_scalar, true},
+    };
+    count = sizeof(table) / sizeof(table[0]);
+    return table;
+}
+
+/**
+ * @brief Compare a kernel with the scalar path, including saturating lanes
+ */
+inline bool self_check(Kernel kernel) {
+    constexpr size_t N = 72;
+    uint32_t wire[N];
+    uint64_t expected[N];
+    uint64_t actual[N];
+    for (size_t count = 0; count <= N; ++count) {
+        for (size_t i = 0; i < N; ++i) {
+            wire[i] = __builtin_bswap32(static_cast<uint32_t>(i * 0x9e3779b9u));
+            // Every fifth bin sits just below the limit so it must saturate
+            expected[i] = actual[i] = i % 5 == 0 ? UINT64_MAX - i : i * 0x100000001ull;
+        }
+        bool expected_overflow = add_scalar(expected, wire, count);
+        bool actual_overflow = kernel(actual, wire, count);
+        if (expected_overflow != actual_overflow || memcmp(expected, actual, sizeof(expected)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline const KernelInfo& select() {
+    size_t count = 0;
+    const KernelInfo* table = kernels(count);
+    for (size_t i = 0; i + 1 < count; ++i) {
+        if (!table[i].supported) {
+            continue;
+        }
+        if (self_check(table[i].kernel)) {
+            return table[i];
+        }
+        std::cerr << "Accumulate kernel " << table[i].name
+                  << " failed its self-check, trying the next one" << std::endl;
+    }
+    return table[count - 1];
+}
+
+inline const KernelInfo& active() {
+    static const KernelInfo& chosen = select();
+    return chosen;
+}
+
+/**
+ * @brief Staging: add wire counts into 32-bit sums, carrying wraps into the 64-bit sum
+ *
+ * staging[i] + 2^32 * (carries added to sum[i]) is exact. Wraps only happen
+ * when the caller's headroom estimate was beaten by an outlier frame, so the
+ * carry is a rare scalar fix-up. The kernels also report the largest staged
+ * value and the largest incoming count, which drive the caller's flushes.
+ */
+struct StageStats {
+    uint32_t staged_max = 0;  // Largest staging value after the add
+    uint32_t frame_max = 0;   // Largest incoming count
+    uint64_t carries = 0;     // Bins that wrapped and were carried into the 64-bit sum
+    bool overflow = false;    // A carry saturated the 64-bit sum
+};
+
+using StageKernel = void (*)(uint32_t*, uint64_t*, const uint32_t*, size_t, StageStats&);
+
+inline void carry_into(uint64_t& sum, StageStats& stats) {
+    uint64_t value = sum + (uint64_t{1} << 32);
+    bool wrapped = value < sum;
+    stats.overflow |= wrapped;
+    sum = wrapped ? UINT64_MAX : value;
+    ++stats.carries;
+}
+
+inline void stage_scalar(uint32_t* staging, uint64_t* sum, const uint32_t* wire, size_t count,
+                         StageStats& stats) {
+    uint32_t staged_max = stats.staged_max;
+    uint32_t frame_max = stats.frame_max;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t value = __builtin_bswap32(wire[i]);
+        uint32_t staged = staging[i] + value;
+        if (__builtin_expect(staged < value, 0)) {
+            carry_into(sum[i], stats);
+        }
+        staging[i] = staged;
+        staged_max = staged > staged_max ? staged : staged_max;
+        frame_max = value > frame_max ? value : frame_max;
+    }
+    stats.staged_max = staged_max;
+    stats.frame_max = frame_max;
+}
+
+#ifdef TPX3_BYTESWAP_X86
+
+__attribute__((target("avx2")))
+inline uint32_t reduce_max_epu32(__m256i v) {
+    __m128i m = _mm_max_epu32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    m = _mm_max_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_max_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(m));
+}
+
+__attribute__((target("avx2")))
+inline void stage_avx2(uint32_t* staging, uint64_t* sum, const uint32_t* wire, size_t count,
+                       StageStats& stats) {
+    const __m256i shuffle = _mm256_set_epi8(
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    __m256i staged_max = _mm256_set1_epi32(static_cast<int>(stats.staged_max));
+    __m256i frame_max = _mm256_set1_epi32(static_cast<int>(stats.frame_max));
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i value = _mm256_shuffle_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wire + i)), shuffle);
+        __m256i* out = reinterpret_cast<__m256i*>(staging + i);
+        __m256i staged = _mm256_add_epi32(_mm256_loadu_si256(out), value);
+        _mm256_storeu_si256(out, staged);
+        // A lane wrapped iff the result is below the added value
+        __m256i kept = _mm256_cmpeq_epi32(_mm256_max_epu32(staged, value), staged);
+        int wrapped = ~_mm256_movemask_ps(_mm256_castsi256_ps(kept)) & 0xff;
+        while (__builtin_expect(wrapped != 0, 0)) {
+            carry_into(sum[i + __builtin_ctz(wrapped)], stats);
+            wrapped &= wrapped - 1;
+        }
+        staged_max = _mm256_max_epu32(staged_max, staged);
+        frame_max = _mm256_max_epu32(frame_max, value);
+    }
+
+    stats.staged_max = reduce_max_epu32(staged_max);
+    stats.frame_max = reduce_max_epu32(frame_max);
+    stage_scalar(staging + i, sum + i, wire + i, count - i, stats);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline void stage_avx512(uint32_t* staging, uint64_t* sum, const uint32_t* wire, size_t count,
+                         StageStats& stats) {
+    const __m512i shuffle = _mm512_set_epi32(
+        0x0c0d0e0f, 0x08090a0b, 0x04050607, 0x00010203,
+        0x0c0d0e0f, 0x08090a0b, 0x04050607, 0x00010203,
+        0x0c0d0e0f, 0x08090a0b, 0x04050607, 0x00010203,
+        0x0c0d0e0f, 0x08090a0b, 0x04050607, 0x00010203);
+    __m512i staged_max = _mm512_set1_epi32(static_cast<int>(stats.staged_max));
+    __m512i frame_max = _mm512_set1_epi32(static_cast<int>(stats.frame_max));
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i value = _mm512_shuffle_epi8(_mm512_loadu_si512(wire + i), shuffle);
+        __m512i staged = _mm512_add_epi32(_mm512_loadu_si512(staging + i), value);
+        _mm512_storeu_si512(staging + i, staged);
+        __mmask16 wrapped = _mm512_cmplt_epu32_mask(staged, value);
+        while (__builtin_expect(wrapped != 0, 0)) {
+            carry_into(sum[i + __builtin_ctz(wrapped)], stats);
+            wrapped &= wrapped - 1;
+        }
+        // maskz forms again avoid the GCC 12 -Wmaybe-uninitialized false positive
+        staged_max = _mm512_maskz_max_epu32(0xffff, staged_max, staged);
+        frame_max = _mm512_maskz_max_epu32(0xffff, frame_max, value);
+    }
+
+    // Reduce through memory; _mm512_reduce_max_epu32 trips the same warning
+    alignas(64) uint32_t lanes[2][16];
+    _mm512_store_si512(lanes[0], staged_max);
+    _mm512_store_si512(lanes[1], frame_max);
+    for (size_t lane = 0; lane < 16; ++lane) {
+        stats.staged_max = lanes[0][lane] > stats.staged_max ? lanes[0][lane] : stats.staged_max;
+        stats.frame_max = lanes[1][lane] > stats.frame_max ? lanes[1][lane] : stats.frame_max;
+    }
+    stage_scalar(staging + i, sum + i, wire + i, count - i, stats);
+}
+
+#endif // TPX3_BYTESWAP_X86
+
+struct StageKernelInfo {
+    const char* name;
+    StageKernel kernel;
+    bool supported;
+};
+
+inline const StageKernelInfo* stage_kernels(size_t& count) {
+    static const StageKernelInfo table[] = {
+#ifdef TPX3_BYTESWAP_X86
+        {"avx512", stage_avx512,
+         __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")},
+        {"avx2", stage_avx2, static_cast<bool>(__builtin_cpu_supports("avx2"))},
+#endif
+        {"scalar", stage_scalar, true},
+    };
+    count = sizeof(table) / sizeof(table[0]);
+    return table;
+}
+
+/**
+ * @brief Compare a staging kernel with the scalar path, including wrapping lanes
+ */
+inline bool stage_self_check(StageKernel kernel) {
+    constexpr size_t N = 72;
+    uint32_t wire[N];
+    uint32_t staging_expected[N];
+    uint32_t staging_actual[N];
+    uint64_t sum_expected[N];
+    uint64_t sum_actual[N];
+    for (size_t count = 0; count <= N; ++count) {
+        for (size_t i = 0; i < N; ++i) {
+            wire[i] = __builtin_bswap32(static_cast<uint32_t>(i * 0x9e3779b9u));
+            // Every seventh bin is about to wrap
+            staging_expected[i] = staging_actual[i] = i % 7 == 0 ? UINT32_MAX - static_cast<uint32_t>(i)
+                                                                 : static_cast<uint32_t>(i);
+            sum_expected[i] = sum_actual[i] = i;
+        }
+        StageStats expected{3, 5, 0, false};
+        StageStats actual{3, 5, 0, false};
+        stage_scalar(staging_expected, sum_expected, wire, count, expected);
+        kernel(staging_actual, sum_actual, wire, count, actual);
+        if (memcmp(staging_expected, staging_actual, sizeof(staging_expected)) != 0 ||
+            memcmp(sum_expected, sum_actual, sizeof(sum_expected)) != 0 ||
+            expected.staged_max != actual.staged_max || expected.frame_max != actual.frame_max ||
+            expected.carries != actual.carries || expected.overflow != actual.overflow) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline const StageKernelInfo& select_stage() {
+    size_t count = 0;
+    const StageKernelInfo* table = stage_kernels(count);
+    for (size_t i = 0; i + 1 < count; ++i) {
+        if (!table[i].supported) {
+            continue;
+        }
+        if (stage_self_check(table[i].kernel)) {
+            return table[i];
+        }
+        std::cerr << "Staging kernel " << table[i].name
+                  << " failed its self-check, trying the next one" << std::endl;
+    }
+    return table[count - 1];
+}
+
+inline const StageKernelInfo& active_stage() {
+    static const StageKernelInfo& chosen = select_stage();
+    return chosen;
+}
+
+} // namespace accumulate
+
+/**
+ * @brief Add count big-endian uint32 counts to a 64-bit running sum, saturating
+ * @return true if at least one bin overflowed and was capped at UINT64_MAX
+ */
+inline bool accumulate_be32(uint64_t* sum, const uint32_t* wire, size_t count) {
+    return accumulate::active().kernel(sum, wire, count);
+}
+
+/**
+ * @brief Name of the kernel accumulate_be32() dispatches to
+ */
+inline const char* accumulate_kernel_name() {
+    return accumulate::active().name;
+}
+
+/**
+ * @brief Add count big-endian uint32 counts to 32-bit staging sums
+ * @param sum The 64-bit sums the staging bins belong to; wrapped bins carry 2^32 into them
+ * @param stats Updated with the staged and incoming maxima, carries and overflow
+ */
+inline void stage_be32(uint32_t* staging, uint64_t* sum, const uint32_t* wire, size_t count,
+                       accumulate::StageStats& stats) {
+    accumulate::active_stage().kernel(staging, sum, wire, count, stats);
+}
+
+/**
+ * @brief Name of the kernel stage_be32() dispatches to
+ */
+inline const char* stage_kernel_name() {
+    return accumulate::active_stage().name;
+}
+
+#endif // TPX3_ACCUMULATE_H
@@ -0,0 +1,152 @@
+#ifndef TPX3_BYTESWAP_H
+#define TPX3_BYTESWAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TPX3_BYTESWAP_X86 1
+#endif
+
+/**
+ * @brief In-place 32-bit byte-swap kernels (AVX-512BW, AVX2, SSSE3, scalar)
+ *
+ * The running sum is fed by the fused swap-and-add in tpx3_accumulate.h, so
+ * the application no longer swaps payloads on their own. These kernels are
+ * the two-pass reference of bench_byteswap and bench_accumulate; the x86
+ * detection and intrinsics here are shared with the fused kernels. Each
+ * kernel handles any length and alignment; the tail is finished with the
+ * scalar loop.
+ */
+namespace byteswap {
+
+using Kernel = void (*)(uint32_t*, size_t);
+
+inline void swap_scalar(uint32_t* values, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = __builtin_bswap32(values[i]);
+    }
+}
+
+#ifdef TPX3_BYTESWAP_X86
+
+__attribute__((target("ssse3")))
+inline void swap_ssse3(uint32_t* values, size_t count) {
+    const __m128i shuffle = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i* p = reinterpret_cast<__m128i*>(values + i);
+        _mm_storeu_si128(p, _mm_shuffle_epi8(_mm_loadu_si128(p), shuffle));
+    }
+    swap_scalar(values + i, count - i);
+}
+
+__attribute__((target("avx2")))
+inline void swap_avx2(uint32_t* values, size_t count) {
+    const __m256i shuffle = _mm256_set_epi8(
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    size_t i = 0;
+    // Two vectors per iteration keep both load ports busy
+    for (; i + 16 <= count; i += 16) {
+        __m256i* p = reinterpret_cast<__m256i*>(values + i);
+        __m256i a = _mm256_loadu_si256(p);
+        __m256i b = _mm256_loadu_si256(p + 1);
+        _mm256_storeu_si256(p, _mm256_shuffle_epi8(a, shuffle));
+        _mm256_storeu_si256(p + 1, _mm256_shuffle_epi8(b, shuffle));
+    }
+    for (; i + 8 <= count; i += 8) {
+        __m256i* p = reinterpret_cast<__m256i*>(values + i);
+        _mm256_storeu_si256(p, _mm256_shuffle_epi8(_mm256_loadu_si256(p), shuffle));
+    }
+    swap_scalar(values + i, count - i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline void swap_avx512(uint32_t* values, size_t count) {
+    const __m512i shuffle = _mm512_set_epi32(
+        0x0c0d0e0f, 0x08090a0b, 0x04050607, 0x00010203,
+        0x0c0d0e0f, 0x08090a0b, 0x04050607, 0x00010203,
+        0x0c0d0e0f, 0x08090a0b, 0x04050607, 0x00010203,
+        0x0c0d0e0f, 0x08090a0b, 0x04050607, 0x00010203);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        void* p = values + i;
+        _mm512_storeu_si512(p, _mm512_shuffle_epi8(_mm512_loadu_si512(p), shuffle));
+    }
+    if (i < count) {
+        // Masked load/store finishes the tail without a scalar loop
+        __mmask16 mask = static_cast<__mmask16>((1u << (count - i)) - 1);
+        __m512i tail = _mm512_maskz_loadu_epi32(mask, values + i);
+        _mm512_mask_storeu_epi32(values + i, mask, _mm512_shuffle_epi8(tail, shuffle));
+    }
+}
+
+#endif // TPX3_BYTESWAP_X86
+
+/**
+ * @brief Named kernel for dispatch, benchmarks and self-checks
+ */
+struct KernelInfo {
+    const char* name;
+    Kernel kernel;
+    bool supported;
+};
+
+/**
+ * @brief All kernels compiled in, widest first, with CPU support flags
+ */
+inline const KernelInfo* kernels(size_t& count) {
+    static const KernelInfo table[] = {
+#ifdef TPX3_BYTESWAP_X86
+        {"avx512", swap_avx512,
+         __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")},
+        {"avx2", swap_avx2, static_cast<bool>(__builtin_cpu_supports("avx2"))},
+        {"ssse3", swap_ssse3, static_cast<bool>(__builtin_cpu_supports("ssse3"))},
+#endif
+        {"scalar", swap_scalar, true},
+    };
+    count = sizeof(table) / sizeof(table[0]);
+    return table;
+}
+
+/**
+ * @brief Compare a kernel with the scalar path over every length and offset up to 80 words
+ */
+inline bool self_check(Kernel kernel) {
+    uint32_t expected[96];
+    uint32_t actual[96];
+    for (size_t offset = 0; offset < 4; ++offset) {
+        for (size_t count = 0; count + offset <= 84; ++count) {
+            for (size_t i = 0; i < 96; ++i) {
+                expected[i] = actual[i] = static_cast<uint32_t>(i * 0x01020304u + 0x0a0b0c0du);
+            }
+            swap_scalar(expected + offset, count);
+            kernel(actual + offset, count);
+            if (memcmp(expected, actual, sizeof(expected)) != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Widest kernel the CPU supports that passes the self-check
+ */
+inline const KernelInfo& widest() {
+    size_t count = 0;
+    const KernelInfo* table = kernels(count);
+    for (size_t i = 0; i + 1 < count; ++i) {
+        if (table[i].supported && self_check(table[i].kernel)) {
+            return table[i];
+        }
+    }
+    return table[count - 1];
+}
+
+} // namespace byteswap
+
+#endif // TPX3_BYTESWAP_H
@@ -0,0 +1,158 @@
+#ifndef TPX3_CHECKPOINT_WRITER_H
+#define TPX3_CHECKPOINT_WRITER_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief Background thread that writes checkpoints of a running sum, coalescing requests
+ *
+ * The accumulation thread calls request() after every frame, which only
+ * records the frame count and wakes the writer. The writer calls the write
+ * task, which captures the current state under the owner's lock and formats
+ * and writes it outside of it. Requests that arrive during a write are
+ * coalesced: the next write covers the latest state once, however many frames
+ * came in meanwhile. Writes start at most once per min_interval, so a slow
+ * disk makes the file lag behind (frames_behind()) instead of slowing ingest.
+ *
+ * flush() and the destructor wait until everything requested has been written.
+ */
+class CheckpointWriter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @param write Writes one checkpoint and returns the frame count it covers; runs on the writer thread
+     * @param min_interval Shortest time between the starts of two writes (0 = back to back)
+     */
+    CheckpointWriter(std::function<uint64_t()> write, Clock::duration min_interval)
+        : write_(std::move(write)), min_interval_(min_interval),
+          thread_(&CheckpointWriter::writer_loop, this) {}
+
+    ~CheckpointWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        thread_.join();
+    }
+
+    // Disable copy
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    /**
+     * @brief Ask for a checkpoint covering the first frames frames
+     */
+    void request(uint64_t frames) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            requested_ = std::max(requested_, frames);
+            ++requests_;
+        }
+        wake_.notify_one();
+    }
+
+    /**
+     * @brief Ask for a checkpoint although no frame was added, e.g. because a time window moved
+     */
+    void refresh() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++refreshes_requested_;
+        }
+        wake_.notify_one();
+    }
+
+    /**
+     * @brief Write now, ignoring the minimum interval, and wait until all requests and refreshes are covered
+     */
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        uint64_t target = requested_;
+        uint64_t refreshes = refreshes_requested_;
+        ++flush_waiters_;
+        wake_.notify_one();
+        written_cv_.wait(lock, [&] { return written_ >= target && refreshes_written_ >= refreshes; });
+        --flush_waiters_;
+    }
+
+    /**
+     * @brief Frames added since the data of the latest checkpoint was captured
+     */
+    uint64_t frames_behind() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return requested_ - written_;
+    }
+
+    /**
+     * @brief Largest frames_behind() seen when a write started
+     */
+    uint64_t max_frames_behind() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return max_frames_behind_;
+    }
+
+    uint64_t writes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return writes_;
+    }
+
+    uint64_t requests() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return requests_;
+    }
+
+private:
+    void writer_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Clock::time_point last_write{};
+        while (true) {
+            wake_.wait(lock, [this] { return stopping_ || requested_ > written_ || refresh_pending(); });
+            if (requested_ <= written_ && !refresh_pending()) {
+                return;  // Stopping with nothing left to write
+            }
+            if (min_interval_ > Clock::duration::zero()) {
+                wake_.wait_until(lock, last_write + min_interval_,
+                                 [this] { return stopping_ || flush_waiters_ > 0; });
+            }
+
+            max_frames_behind_ = std::max(max_frames_behind_, requested_ - written_);
+            last_write = Clock::now();
+            uint64_t refreshes = refreshes_requested_;
+            lock.unlock();
+            uint64_t covered = write_();
+            lock.lock();
+            written_ = std::max(written_, covered);
+            refreshes_written_ = refreshes;
+            ++writes_;
+            written_cv_.notify_all();
+        }
+    }
+
+    bool refresh_pending() const { return refreshes_requested_ > refreshes_written_; }
+
+    std::function<uint64_t()> write_;
+    Clock::duration min_interval_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable written_cv_;
+    uint64_t requested_ = 0;           // Frames the newest request covers
+    uint64_t written_ = 0;             // Frames the newest checkpoint covers
+    uint64_t requests_ = 0;
+    uint64_t writes_ = 0;
+    uint64_t max_frames_behind_ = 0;
+    size_t flush_waiters_ = 0;
+    uint64_t refreshes_requested_ = 0; // Writes asked for although no frames were requested
+    uint64_t refreshes_written_ = 0;   // Refreshes the newest checkpoint covers
+    bool stopping_ = false;
+    std::thread thread_;               // Last, so it starts after everything above is initialised
+};
+
+#endif // TPX3_CHECKPOINT_WRITER_H
@@ -0,0 +1,142 @@
+#ifndef TPX3_CHUNKED_STORAGE_H
+#define TPX3_CHUNKED_STORAGE_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include "tpx3_span.h"
+
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/**
+ * @brief One 2 MB block of anonymous memory, on a huge page when possible
+ *
+ * Tries an explicit MAP_HUGETLB page first. Without reserved huge pages it
+ * maps a 2 MB-aligned region and asks for a transparent huge page with
+ * MADV_HUGEPAGE. Either way the memory is zero-filled.
+ */
+class HugePageBlock {
+public:
+    HugePageBlock() {
+        void* memory = mmap(nullptr, HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED) {
+            data_ = memory;
+            explicit_huge_page_ = true;
+            return;
+        }
+
+        // Over-map so a 2 MB-aligned block can be carved out for THP
+        size_t span = 2 * HUGE_PAGE_SIZE;
+        char* region = static_cast<char*>(mmap(nullptr, span, PROT_READ | PROT_WRITE,
+                                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (region == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        uintptr_t base = reinterpret_cast<uintptr_t>(region);
+        uintptr_t aligned = (base + HUGE_PAGE_SIZE - 1) & ~(uintptr_t{HUGE_PAGE_SIZE} - 1);
+        char* block = reinterpret_cast<char*>(aligned);
+        if (block > region) {
+            munmap(region, block - region);
+        }
+        char* block_end = block + HUGE_PAGE_SIZE;
+        if (region + span > block_end) {
+            munmap(block_end, region + span - block_end);
+        }
+        madvise(block, HUGE_PAGE_SIZE, MADV_HUGEPAGE);
+        data_ = block;
+    }
+
+    ~HugePageBlock() {
+        if (data_) {
+            munmap(data_, HUGE_PAGE_SIZE);
+        }
+    }
+
+    HugePageBlock(HugePageBlock&& other) noexcept
+        : data_(other.data_), explicit_huge_page_(other.explicit_huge_page_) {
+        other.data_ = nullptr;
+    }
+    HugePageBlock& operator=(HugePageBlock&&) = delete;
+    HugePageBlock(const HugePageBlock&) = delete;
+    HugePageBlock& operator=(const HugePageBlock&) = delete;
+
+    void* data() const { return data_; }
+
+    /**
+     * @brief true if backed by a reserved (hugetlbfs) page rather than THP
+     */
+    bool explicit_huge_page() const { return explicit_huge_page_; }
+
+private:
+    void* data_ = nullptr;
+    bool explicit_huge_page_ = false;
+};
+
+/**
+ * @brief Histogram bin storage split into independent 2 MB chunks
+ *
+ * Large running sums (10^6 - 10^7 bins) never need one contiguous
+ * allocation, each chunk sits on its own huge page to keep TLB misses down,
+ * and chunks are natural units for parallel accumulation.
+ */
+template <typename T>
+class ChunkedStorage {
+public:
+    static constexpr size_t CHUNK_ELEMENTS = HUGE_PAGE_SIZE / sizeof(T);
+
+    explicit ChunkedStorage(size_t count) : size_(count) {
+        size_t chunks = (count + CHUNK_ELEMENTS - 1) / CHUNK_ELEMENTS;
+        blocks_.reserve(chunks);
+        for (size_t c = 0; c < chunks; ++c) {
+            blocks_.emplace_back();
+        }
+    }
+
+    size_t size() const { return size_; }
+    size_t chunk_count() const { return blocks_.size(); }
+    size_t chunk_offset(size_t chunk) const { return chunk * CHUNK_ELEMENTS; }
+
+    Span<T> chunk(size_t chunk) {
+        return {static_cast<T*>(blocks_[chunk].data()), chunk_length(chunk)};
+    }
+    Span<const T> chunk(size_t chunk) const {
+        return {static_cast<const T*>(blocks_[chunk].data()), chunk_length(chunk)};
+    }
+
+    T& operator[](size_t index) {
+        assert(index < size_);
+        return static_cast<T*>(blocks_[index / CHUNK_ELEMENTS].data())[index % CHUNK_ELEMENTS];
+    }
+    const T& operator[](size_t index) const {
+        assert(index < size_);
+        return static_cast<const T*>(blocks_[index / CHUNK_ELEMENTS].data())[index % CHUNK_ELEMENTS];
+    }
+
+    /**
+     * @brief Chunks backed by reserved huge pages (the rest rely on THP)
+     */
+    size_t explicit_huge_pages() const {
+        size_t count = 0;
+        for (const auto& block : blocks_) {
+            count += block.explicit_huge_page() ? 1 : 0;
+        }
+        return count;
+    }
+
+private:
+    size_t chunk_length(size_t chunk) const {
+        size_t offset = chunk * CHUNK_ELEMENTS;
+        return size_ - offset < CHUNK_ELEMENTS ? size_ - offset : CHUNK_ELEMENTS;
+    }
+
+    size_t size_;
+    std::vector<HugePageBlock> blocks_;
+};
+
+#endif // TPX3_CHUNKED_STORAGE_H
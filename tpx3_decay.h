@@ -0,0 +1,257 @@
+#ifndef TPX3_DECAY_H
+#define TPX3_DECAY_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tpx3_byteswap.h"  // x86 detection and intrinsics
+#include "tpx3_histogram_data.h"
+
+/**
+ * @brief Kernels for the decayed sum: scaled[i] += count[i] * weight over a wire payload
+ *
+ * One fused multiply-add per bin, straight from the big-endian payload. The
+ * unsigned 32-bit counts are widened to double exactly (AVX2 via the 2^52
+ * magic-number trick, AVX-512 natively). Chosen from CPUID like the other
+ * kernels; FMA rounds differently from a separate multiply and add, so the
+ * self-check allows a relative error of 1e-12.
+ */
+namespace decay {
+
+using Kernel = void (*)(double*, const uint32_t*, size_t, double);
+
+inline void fma_scalar(double* scaled, const uint32_t* wire, size_t count, double weight) {
+    for (size_t i = 0; i < count; ++i) {
+        scaled[i] += static_cast<double>(__builtin_bswap32(wire[i])) * weight;
+    }
+}
+
+#ifdef TPX3_BYTESWAP_X86
+
+__attribute__((target("avx2,fma")))
+inline void fma_avx2(double* scaled, const uint32_t* wire, size_t count, double weight) {
+    const __m256i shuffle = _mm256_set_epi8(
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    // OR-ing a 32-bit integer into the mantissa of 2^52 and subtracting 2^52 converts it exactly
+    const __m256i magic_bits = _mm256_set1_epi64x(0x4330000000000000ll);
+    const __m256d magic = _mm256_set1_pd(4503599627370496.0);
+    const __m256d factor = _mm256_set1_pd(weight);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i counts = _mm256_shuffle_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wire + i)), shuffle);
+        __m256i low = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(counts));
+        __m256i high = _mm256_cvtepu32_epi64(_mm256_extracti128_si256(counts, 1));
+        __m256d low_pd = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(low, magic_bits)), magic);
+        __m256d high_pd = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(high, magic_bits)), magic);
+        _mm256_storeu_pd(scaled + i, _mm256_fmadd_pd(low_pd, factor, _mm256_loadu_pd(scaled + i)));
+        _mm256_storeu_pd(scaled + i + 4, _mm256_fmadd_pd(high_pd, factor, _mm256_loadu_pd(scaled + i + 4)));
+    }
+    fma_scalar(scaled + i, wire + i, count - i, weight);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline void fma_avx512(double* scaled, const uint32_t* wire, size_t count, double weight) {
+    const __m256i shuffle = _mm256_set_epi8(
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    const __m512d factor = _mm512_set1_pd(weight);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i counts = _mm256_shuffle_epi8(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(wire + i)), shuffle);
+        // maskz form: see accumulate::add_avx512
+        __m512d values = _mm512_maskz_cvtepu32_pd(0xff, counts);
+        _mm512_storeu_pd(scaled + i, _mm512_fmadd_pd(values, factor, _mm512_loadu_pd(scaled + i)));
+    }
+    fma_scalar(scaled + i, wire + i, count - i, weight);
+}
+
+#endif // TPX3_BYTESWAP_X86
+
+struct KernelInfo {
+    const char* name;
+    Kernel kernel;
+    bool supported;
+};
+
+inline const KernelInfo* kernels(size_t& count) {
+    static const KernelInfo table[] = {
+#ifdef TPX3_BYTESWAP_X86
+        {"avx512", fma_avx512,
+         __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")},
+        {"avx2", fma_avx2, __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")},
+#endif
+        {"scalar", fma_scalar, true},
+    };
+    count = sizeof(table) / sizeof(table[0]);
+    return table;
+}
+
+/**
+ * @brief Compare a kernel with the scalar path, including counts above 2^31
+ */
+inline bool self_check(Kernel kernel) {
+    constexpr size_t N = 40;
+    uint32_t wire[N];
+    double expected[N];
+    double actual[N];
+    for (size_t count = 0; count <= N; ++count) {
+        for (size_t i = 0; i < N; ++i) {
+            wire[i] = __builtin_bswap32(static_cast<uint32_t>(i * 0x9e3779b9u));
+            expected[i] = actual[i] = static_cast<double>(i) * 0.5;
+        }
+        fma_scalar(expected, wire, count, 0.75);
+        kernel(actual, wire, count, 0.75);
+        for (size_t i = 0; i < N; ++i) {
+            if (std::fabs(expected[i] - actual[i]) > 1e-12 * std::fabs(expected[i])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+inline const KernelInfo& select() {
+    size_t count = 0;
+    const KernelInfo* table = kernels(count);
+    for (size_t i = 0; i + 1 < count; ++i) {
+        if (!table[i].supported) {
+            continue;
+        }
+        if (self_check(table[i].kernel)) {
+            return table[i];
+        }
+        std::cerr << "Decay kernel " << table[i].name
+                  << " failed its self-check, trying the next one" << std::endl;
+    }
+    return table[count - 1];
+}
+
+inline const KernelInfo& active() {
+    static const KernelInfo& chosen = select();
+    return chosen;
+}
+
+} // namespace decay
+
+/**
+ * @brief Which outputs keep a decayed sum
+ */
+enum class DecayOutputs {
+    ALL,       // Every source and the combined sum
+    SOURCES,   // Per-source sums only
+    COMBINED,  // The combined sum only
+};
+
+inline DecayOutputs parse_decay_outputs(const std::string& name) {
+    if (name == "all") {
+        return DecayOutputs::ALL;
+    }
+    if (name == "sources") {
+        return DecayOutputs::SOURCES;
+    }
+    if (name == "combined") {
+        return DecayOutputs::COMBINED;
+    }
+    throw std::invalid_argument("Unknown decay outputs: " + name + " (expected all, sources or combined)");
+}
+
+/**
+ * @brief Exponentially decayed sum, sum = sum * alpha + frame, with lazy rescaling
+ *
+ * Instead of multiplying every bin by alpha on each frame, the sum is kept as
+ * scaled values and one common scale: sum[i] = scaled[i] * scale. A frame
+ * multiplies the scale by alpha and adds count / scale to each scaled bin, so
+ * every frame is a single fused multiply-add pass with one division per
+ * frame, not per bin. When the scale underflows towards RESCALE_BELOW, the
+ * scale is folded into the values once and reset to 1. Memory stays at one
+ * double per bin.
+ */
+class DecayedSum {
+public:
+    static constexpr double RESCALE_BELOW = 1e-150;
+
+    DecayedSum(std::shared_ptr<const BinAxis> axis, double alpha)
+        : axis_(std::move(axis)), alpha_(alpha), scaled_(axis_->bin_count(), 0.0) {
+        if (!(alpha > 0.0 && alpha < 1.0)) {
+            throw std::invalid_argument("Decay factor must be between 0 and 1");
+        }
+    }
+
+    const BinAxis& axis() const { return *axis_; }
+    size_t get_bin_size() const { return scaled_.size(); }
+    double alpha() const { return alpha_; }
+
+    double value(size_t index) const { return scaled_[index] * scale_; }
+
+    /**
+     * @brief Write the decayed sum of every bin to out, in one pass that vectorizes
+     */
+    void copy_values(double* out) const {
+        const double* scaled = scaled_.data();
+        for (size_t i = 0; i < scaled_.size(); ++i) {
+            out[i] = scaled[i] * scale_;
+        }
+    }
+
+    /**
+     * @brief Decay the sum and add big-endian 32-bit counts, as received
+     */
+    void add_be32(const uint32_t* wire, size_t count) {
+        double weight = next_weight(count);
+        decay::active().kernel(scaled_.data(), wire, count, weight);
+    }
+
+    /**
+     * @brief Decay the sum and add count_at(i) for every bin
+     */
+    template <typename CountAt>
+    void add(size_t count, const CountAt& count_at) {
+        double weight = next_weight(count);
+        for (size_t i = 0; i < count; ++i) {
+            scaled_[i] += static_cast<double>(count_at(i)) * weight;
+        }
+    }
+
+    uint64_t rescales() const { return rescales_; }
+
+    static const char* kernel_name() { return decay::active().name; }
+
+private:
+    /**
+     * @brief Advance the scale by one frame
+     * @return Factor that turns a count into a scaled value
+     */
+    double next_weight(size_t count) {
+        if (count != scaled_.size()) {
+            throw std::invalid_argument("Bin sizes must match for addition");
+        }
+        scale_ *= alpha_;
+        if (scale_ < RESCALE_BELOW) {
+            for (double& value : scaled_) {
+                value *= scale_;
+            }
+            scale_ = 1.0;
+            ++rescales_;
+        }
+        return 1.0 / scale_;
+    }
+
+    std::shared_ptr<const BinAxis> axis_;
+    double alpha_;
+    double scale_ = 1.0;
+    std::vector<double> scaled_;
+    uint64_t rescales_ = 0;
+};
+
+#endif // TPX3_DECAY_H
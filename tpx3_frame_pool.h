@@ -0,0 +1,172 @@
+#ifndef TPX3_FRAME_POOL_H
+#define TPX3_FRAME_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "tpx3_spsc_ring.h"
+
+constexpr size_t FRAME_BUFFER_ALIGNMENT = 64;
+
+/**
+ * @brief Header fields of one frame as announced by the server
+ */
+struct FrameHeader {
+    int frame_number = 0;
+    int bin_size = 0;
+    int bin_width = 0;
+    int bin_offset = 0;
+    long long data_size = -1;  // Payload bytes announced by the server, -1 if absent
+};
+
+/**
+ * @brief Recyclable frame: header plus a cache-aligned payload buffer
+ *
+ * The payload is received in network byte order directly into data() and stays
+ * that way; the consumer converts it while accumulating.
+ */
+class FrameBuffer {
+public:
+    FrameBuffer() = default;
+
+    // Disable copy (owned by FramePool)
+    FrameBuffer(const FrameBuffer&) = delete;
+    FrameBuffer& operator=(const FrameBuffer&) = delete;
+
+    FrameHeader header;
+    size_t source = 0;  // Index of the server the frame came from
+
+    uint32_t* data() { return data_.get(); }
+    const uint32_t* data() const { return data_.get(); }
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Raw byte view of the payload for receiving into
+     */
+    char* bytes() { return reinterpret_cast<char*>(data_.get()); }
+
+private:
+    friend class FramePool;
+
+    struct AlignedFree {
+        void operator()(uint32_t* p) const { std::free(p); }
+    };
+
+    std::unique_ptr<uint32_t, AlignedFree> data_;
+    size_t capacity_ = 0;  // In bins
+};
+
+/**
+ * @brief Fixed set of preallocated frame buffers shared by one producer and one consumer
+ *
+ * The producer (receive thread) acquires buffers and the consumer (accumulation
+ * thread) releases them; released buffers travel back through an SpscRing, so
+ * no lock is taken. The producer moves them onto a stack and hands out the most
+ * recently released one first, so only as many buffers as are ever in flight
+ * at once get used. Payload storage is only (re)allocated when a frame needs
+ * more bins than a buffer holds; with the stack, a large frame size grows a
+ * few hot buffers rather than every buffer in turn. Regrowths are counted
+ * apart from the initial fill.
+ */
+class FramePool {
+public:
+    FramePool(size_t buffer_count, size_t initial_bins)
+        : buffers_(buffer_count), released_(buffer_count) {
+        free_.reserve(buffer_count);
+        for (auto& buffer : buffers_) {
+            if (initial_bins > 0) {
+                reserve(buffer, initial_bins);
+            }
+            free_.push_back(&buffer);
+        }
+        initial_allocations_ = allocations();
+    }
+
+    // Disable copy
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    /**
+     * @brief Take a free buffer able to hold bin_count bins (producer thread only)
+     * @param bin_count Number of 32-bit bins the frame needs
+     * @return Buffer, or nullptr if all buffers are in flight
+     */
+    FrameBuffer* try_acquire(size_t bin_count) {
+        FrameBuffer* buffer = nullptr;
+        // Oldest first onto the stack, so the most recently released buffer ends up on top
+        while (released_.try_pop(buffer)) {
+            free_.push_back(buffer);
+        }
+        if (free_.empty()) {
+            return nullptr;
+        }
+        buffer = free_.back();
+        free_.pop_back();
+        if (buffer->capacity_ < bin_count) {
+            reserve(*buffer, bin_count);
+        }
+        return buffer;
+    }
+
+    /**
+     * @brief Return a buffer to the pool (consumer thread only)
+     */
+    void release(FrameBuffer* buffer) {
+        released_.try_push(std::move(buffer));
+    }
+
+    /**
+     * @brief Give back a buffer that was acquired but never queued (producer thread only)
+     *
+     * Goes straight onto the free stack, which has room for every buffer (never reallocated).
+     */
+    void release_from_producer(FrameBuffer* buffer) {
+        free_.push_back(buffer);
+    }
+
+    size_t buffer_count() const { return buffers_.size(); }
+
+    /**
+     * @brief Number of payload allocations performed since construction
+     */
+    uint64_t allocations() const { return allocations_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Payload allocations made after the initial fill, i.e. buffers grown for larger frames
+     */
+    uint64_t regrowths() const { return allocations() - initial_allocations_; }
+
+    /**
+     * @brief Payload bytes currently held by all buffers
+     */
+    uint64_t reserved_bytes() const { return reserved_bytes_.load(std::memory_order_relaxed); }
+
+private:
+    void reserve(FrameBuffer& buffer, size_t bin_count) {
+        size_t bytes = bin_count * sizeof(uint32_t);
+        bytes = (bytes + FRAME_BUFFER_ALIGNMENT - 1) & ~(FRAME_BUFFER_ALIGNMENT - 1);
+
+        void* memory = std::aligned_alloc(FRAME_BUFFER_ALIGNMENT, bytes);
+        if (!memory) {
+            throw std::bad_alloc();
+        }
+        reserved_bytes_.fetch_add(bytes - buffer.capacity_ * sizeof(uint32_t), std::memory_order_relaxed);
+        buffer.data_.reset(static_cast<uint32_t*>(memory));
+        buffer.capacity_ = bytes / sizeof(uint32_t);
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::vector<FrameBuffer> buffers_;
+    SpscRing<FrameBuffer*> released_;  // Consumer to producer
+    std::vector<FrameBuffer*> free_;  // Producer thread only; the top is the most recently released
+    std::atomic<uint64_t> allocations_{0};
+    uint64_t initial_allocations_ = 0;
+    std::atomic<uint64_t> reserved_bytes_{0};
+};
+
+#endif // TPX3_FRAME_POOL_H
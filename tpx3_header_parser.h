@@ -0,0 +1,206 @@
+#ifndef TPX3_HEADER_PARSER_H
+#define TPX3_HEADER_PARSER_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "tpx3_frame_pool.h"
+
+constexpr int MAX_FRAME_BINS = 1 << 24;
+
+/**
+ * @brief Fast-path parse of a frame header with the known flat layout
+ * @param begin First character of the line
+ * @param end One past the last character (newline excluded)
+ * @param header Receives the parsed fields
+ * @return true if parsed; false means "not recognized", not "invalid"
+ *
+ * Handles a flat JSON object whose keys are all among frameNumber, binSize,
+ * binWidth, binOffset, dataSize and countSum, with plain integer values and
+ * optional whitespace, in any order. It works on the buffer in place and
+ * allocates nothing. Anything else (unknown keys, escapes, non-integer or
+ * out-of-range numbers, a missing required key, trailing bytes) is left to
+ * the nlohmann fallback, which also produces the error message.
+ */
+inline bool parse_frame_header_fast(const char* begin, const char* end, FrameHeader& header) {
+    enum Field : unsigned {
+        FRAME_NUMBER = 1, BIN_SIZE = 2, BIN_WIDTH = 4, BIN_OFFSET = 8,
+        DATA_SIZE = 16, COUNT_SUM = 32
+    };
+    constexpr unsigned REQUIRED = FRAME_NUMBER | BIN_SIZE | BIN_WIDTH | BIN_OFFSET;
+
+    const char* p = begin;
+    auto skip_space = [&] {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+            ++p;
+        }
+    };
+
+    skip_space();
+    if (p == end || *p != '{') {
+        return false;
+    }
+    ++p;
+
+    unsigned seen = 0;
+    long long data_size = -1;
+    while (true) {
+        skip_space();
+        if (p == end || *p != '"') {
+            return false;
+        }
+        const char* key = ++p;
+        while (p < end && *p != '"' && *p != '\\') {
+            ++p;
+        }
+        if (p == end || *p != '"') {
+            return false;
+        }
+        size_t key_length = static_cast<size_t>(p - key);
+        ++p;
+
+        Field field;
+        if (key_length == 11 && memcmp(key, "frameNumber", 11) == 0) {
+            field = FRAME_NUMBER;
+        } else if (key_length == 7 && memcmp(key, "binSize", 7) == 0) {
+            field = BIN_SIZE;
+        } else if (key_length == 8 && memcmp(key, "binWidth", 8) == 0) {
+            field = BIN_WIDTH;
+        } else if (key_length == 9 && memcmp(key, "binOffset", 9) == 0) {
+            field = BIN_OFFSET;
+        } else if (key_length == 8 && memcmp(key, "dataSize", 8) == 0) {
+            field = DATA_SIZE;
+        } else if (key_length == 8 && memcmp(key, "countSum", 8) == 0) {
+            field = COUNT_SUM;
+        } else {
+            return false;
+        }
+        if (seen & field) {
+            return false;  // Duplicate key: let nlohmann apply its rule
+        }
+        seen |= field;
+
+        skip_space();
+        if (p == end || *p != ':') {
+            return false;
+        }
+        ++p;
+        skip_space();
+
+        // JSON integer: optional minus, no leading zeros, at most 18 digits
+        bool negative = p < end && *p == '-';
+        if (negative) {
+            ++p;
+        }
+        const char* digits = p;
+        uint64_t magnitude = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            magnitude = magnitude * 10 + static_cast<unsigned>(*p - '0');
+            ++p;
+        }
+        size_t digit_count = static_cast<size_t>(p - digits);
+        if (digit_count == 0 || digit_count > 18 || (digit_count > 1 && *digits == '0') ||
+            (p < end && (*p == '.' || *p == 'e' || *p == 'E'))) {
+            return false;
+        }
+        long long value = negative ? -static_cast<long long>(magnitude)
+                                   : static_cast<long long>(magnitude);
+
+        if (field != DATA_SIZE && field != COUNT_SUM &&
+            (value < INT32_MIN || value > INT32_MAX)) {
+            return false;
+        }
+        switch (field) {
+            case FRAME_NUMBER: header.frame_number = static_cast<int>(value); break;
+            case BIN_SIZE: header.bin_size = static_cast<int>(value); break;
+            case BIN_WIDTH: header.bin_width = static_cast<int>(value); break;
+            case BIN_OFFSET: header.bin_offset = static_cast<int>(value); break;
+            case DATA_SIZE: data_size = value; break;
+            case COUNT_SUM: break;
+        }
+
+        skip_space();
+        if (p == end) {
+            return false;
+        }
+        if (*p == ',') {
+            ++p;
+            continue;
+        }
+        if (*p != '}') {
+            return false;
+        }
+        ++p;
+        break;
+    }
+
+    skip_space();
+    if (p != end || (seen & REQUIRED) != REQUIRED) {
+        return false;
+    }
+    header.data_size = data_size;
+    return true;
+}
+
+/**
+ * @brief Parse a frame header with nlohmann/json (general but allocating)
+ * @return true if parsed, false with error set on malformed input
+ */
+inline bool parse_frame_header_json(const char* begin, const char* end, FrameHeader& header,
+                                    std::string& error) {
+    try {
+        nlohmann::json j = nlohmann::json::parse(begin, end);
+
+        // Extract header information
+        header.frame_number = j["frameNumber"];
+        header.bin_size = j["binSize"];
+        header.bin_width = j["binWidth"];
+        header.bin_offset = j["binOffset"];
+        header.data_size = j.value("dataSize", -1LL);
+    } catch (const nlohmann::json::parse_error& e) {
+        error = std::string("JSON parse error: ") + e.what();
+        return false;
+    } catch (const std::exception& e) {
+        error = std::string("Invalid header: ") + e.what();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse and validate a JSON frame header line
+ * @param begin First character of the line
+ * @param end One past the last character (newline excluded)
+ * @param header Receives the parsed fields
+ * @param error Receives a description when parsing fails
+ * @return true if the header was parsed, false on malformed input
+ *
+ * Tries parse_frame_header_fast() first and only builds a JSON document for
+ * headers it does not recognize.
+ */
+inline bool parse_frame_header(const char* begin, const char* end, FrameHeader& header,
+                               std::string& error) {
+    if (!parse_frame_header_fast(begin, end, header) &&
+        !parse_frame_header_json(begin, end, header, error)) {
+        return false;
+    }
+
+    if (header.bin_size < 0 || header.bin_size > MAX_FRAME_BINS) {
+        error = "Invalid header: binSize " + std::to_string(header.bin_size) + " out of range";
+        return false;
+    }
+
+    // The announced payload length must agree with binSize
+    if (header.data_size >= 0 &&
+        header.data_size != static_cast<long long>(header.bin_size) * 4) {
+        error = "Invalid header: dataSize " + std::to_string(header.data_size) +
+                " does not match binSize " + std::to_string(header.bin_size);
+        return false;
+    }
+    return true;
+}
+
+#endif // TPX3_HEADER_PARSER_H
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <memory>
@@ -13,463 +14,605 @@
 #include <functional>
 #include <stdexcept>
 #include <system_error>
+#include <cerrno>
+#include <cstdio>
 #include <cstring>
 #include <iomanip>
 #include <filesystem>
 
-// Network includes
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <netinet/tcp.h>
-#include <arpa/inet.h>
-#include <unistd.h>
-#include <fcntl.h>
-#include <errno.h>
-
-// JSON parsing
-#include <nlohmann/json.hpp>
-
-// Use nlohmann namespace for convenience
-using json = nlohmann::json;
+// System includes
+#include <signal.h>
+
+#include "tpx3_accumulate.h"
+#include "tpx3_checkpoint_writer.h"
+#include "tpx3_decay.h"
+#include "tpx3_frame_pool.h"
+#include "tpx3_histogram_data.h"
+#include "tpx3_ingest.h"
+#include "tpx3_rebin.h"
+#include "tpx3_recording.h"
+#include "tpx3_spsc_ring.h"
+#include "tpx3_shm_segment.h"
+#include "tpx3_snapshot_file.h"
+#include "tpx3_staged_sum.h"
+#include "tpx3_stream_framer.h"
+#include "tpx3_text_format.h"
+#include "tpx3_waterfall.h"
+#include "tpx3_window.h"
 
 // Constants
-constexpr double TPX3_TDC_CLOCK_PERIOD_SEC = (1.5625 / 6.0) * 1e-9;
 constexpr size_t MAX_BUFFER_SIZE = 32768;
-constexpr size_t MAX_BINS = 1000;
+constexpr size_t POOL_INITIAL_BINS = 1000;  // Buffers grow on demand up to MAX_FRAME_BINS
 constexpr int DEFAULT_PORT = 8451;
 constexpr const char* DEFAULT_HOST = "127.0.0.1";
+constexpr size_t DEFAULT_QUEUE_CAPACITY = 1024;
+constexpr const char* DEFAULT_OUTPUT_PATH = "data/tof-histogram-running-sum.txt";
+constexpr unsigned DEFAULT_SHM_INTERVAL_MS = 20;  // Live readers rarely poll faster than 50 Hz
+constexpr int WINDOW_IDLE_CHECK_MS = 100;  // How often an idle accumulation thread moves time windows
+
+// Set from SIGINT/SIGTERM; checked by the receive loop between reads
+std::atomic<bool> g_stop_requested{false};
 
 // Forward declarations
-class HistogramData;
-class NetworkClient;
 class HistogramProcessor;
 
 /**
- * @brief Represents histogram data with bin edges and values
+ * @brief Settings shared by all histogram processors
  */
-class HistogramData {
-public:
-    enum class DataType {
-        FRAME_DATA,      // Individual frame data (32-bit)
-        RUNNING_SUM      // Accumulated data (64-bit)
-    };
+struct ProcessorOptions {
+    WorkerPool* workers = nullptr;  // Optional pool that splits large additions by storage chunk
+    GridChangePolicy grid_policy = GridChangePolicy::REBIN;  // Frames on a different bin grid
+    WindowSpec window;              // Also keep a sliding-window sum, if enabled
+    double decay_alpha = 0.0;       // Also keep a decayed sum with this factor (0 = off)
+    WaterfallSpec waterfall;        // Also keep a ToF x time waterfall, if enabled
+    std::chrono::milliseconds checkpoint_interval{0};  // Shortest time between two output writes
+    bool generation_header = false;  // Number checkpoints in a "# Generation:" header line
+    OutputFormats formats;           // Files the running sum is written as
+    std::string shm_name;            // Also publish the running sum to this shared-memory segment
+    std::chrono::milliseconds shm_interval{DEFAULT_SHM_INTERVAL_MS};  // Shortest time between two publishes
+};
 
-    HistogramData(size_t bin_size, DataType type = DataType::FRAME_DATA)
-        : bin_size_(bin_size), data_type_(type) {
-        
-        bin_edges_.resize(bin_size + 1);
-        
-        if (type == DataType::FRAME_DATA) {
-            bin_values_32_.resize(bin_size, 0);
-        } else {
-            bin_values_64_.resize(bin_size, 0);
-        }
-    }
-
-    // Copy constructor
-    HistogramData(const HistogramData& other)
-        : bin_size_(other.bin_size_), data_type_(other.data_type_) {
-        
-        bin_edges_ = other.bin_edges_;
-        
-        if (data_type_ == DataType::FRAME_DATA) {
-            bin_values_32_ = other.bin_values_32_;
-        } else {
-            bin_values_64_ = other.bin_values_64_;
-        }
-    }
-
-    // Move constructor
-    HistogramData(HistogramData&& other) noexcept
-        : bin_size_(other.bin_size_), data_type_(other.data_type_) {
-        
-        bin_edges_ = std::move(other.bin_edges_);
-        bin_values_32_ = std::move(other.bin_values_32_);
-        bin_values_64_ = std::move(other.bin_values_64_);
-        
-        other.bin_size_ = 0;
-        other.data_type_ = DataType::FRAME_DATA;
-    }
-
-    // Assignment operators
-    HistogramData& operator=(const HistogramData& other) {
-        if (this != &other) {
-            bin_size_ = other.bin_size_;
-            data_type_ = other.data_type_;
-            bin_edges_ = other.bin_edges_;
-            
-            if (data_type_ == DataType::FRAME_DATA) {
-                bin_values_32_ = other.bin_values_32_;
-            } else {
-                bin_values_64_ = other.bin_values_64_;
-            }
+/**
+ * @brief Processes histogram data and maintains running sum
+ *
+ * Output files are written by a CheckpointWriter thread: each frame only
+ * requests a checkpoint, and the writer copies the latest state under the
+ * lock and formats it outside of it.
+ */
+class HistogramProcessor {
+public:
+    /**
+     * @param output_path File the running sum is saved to
+     * @param options Worker pool, grid-change policy, optional views and checkpoint interval
+     */
+    explicit HistogramProcessor(std::string output_path = DEFAULT_OUTPUT_PATH,
+                                ProcessorOptions options = {})
+        : output_path_(std::move(output_path)), workers_(options.workers),
+          grid_policy_(options.grid_policy), window_spec_(options.window),
+          decay_alpha_(options.decay_alpha), waterfall_spec_(options.waterfall),
+          generation_header_(options.generation_header), formats_(options.formats),
+          writer_([this] { return write_checkpoint(); }, options.checkpoint_interval) {
+        if (!options.shm_name.empty()) {
+            shm_ = std::make_unique<ShmPublisher>(options.shm_name);
+            shm_writer_ = std::make_unique<CheckpointWriter>([this] { return publish_shm(); },
+                                                             options.shm_interval);
         }
-        return *this;
     }
+    
+    ~HistogramProcessor() = default;
 
-    HistogramData& operator=(HistogramData&& other) noexcept {
-        if (this != &other) {
-            bin_size_ = other.bin_size_;
-            data_type_ = other.data_type_;
-            bin_edges_ = std::move(other.bin_edges_);
-            bin_values_32_ = std::move(other.bin_values_32_);
-            bin_values_64_ = std::move(other.bin_values_64_);
-            
-            other.bin_size_ = 0;
-            other.data_type_ = DataType::FRAME_DATA;
-        }
-        return *this;
-    }
+    // Disable copy and move (the checkpoint writer thread refers to this object)
+    HistogramProcessor(const HistogramProcessor&) = delete;
+    HistogramProcessor& operator=(const HistogramProcessor&) = delete;
 
-    // Destructor
-    ~HistogramData() = default;
+    /**
+     * @brief Process a new frame received into a pooled buffer
+     * @param header Frame header
+     * @param values Bin counts in network byte order, as received
+     *
+     * Converts and adds the counts straight into the 32-bit staging sums in a
+     * single pass, without building a per-frame HistogramData. Frames on
+     * another grid go through the rebinner instead.
+     */
+    void process_frame(const FrameHeader& header, const uint32_t* values) {
+        std::lock_guard<std::mutex> lock(mutex_);
 
-    // Getters
-    size_t get_bin_size() const { return bin_size_; }
-    DataType get_data_type() const { return data_type_; }
-    const std::vector<double>& get_bin_edges() const { return bin_edges_; }
-    
-    // Access bin values based on type
-    uint32_t get_bin_value_32(size_t index) const {
-        if (data_type_ != DataType::FRAME_DATA || index >= bin_values_32_.size()) {
-            throw std::out_of_range("Invalid index or data type for 32-bit access");
+        const RebinTable* table = prepare_running_sum(header.bin_size, header.bin_width, header.bin_offset);
+        bool overflow = table
+            ? rebinner_->add(running_sum_->sum(), *table, [&](size_t i) { return __builtin_bswap32(values[i]); })
+            : running_sum_->add_be32(values, header.bin_size, workers_);
+        if (overflow) {
+            warn_overflow();
         }
-        return bin_values_32_[index];
-    }
-    
-    uint64_t get_bin_value_64(size_t index) const {
-        if (data_type_ != DataType::RUNNING_SUM || index >= bin_values_64_.size()) {
-            throw std::out_of_range("Invalid index or data type for 64-bit access");
-        }
-        return bin_values_64_[index];
-    }
+        add_to_views(header.frame_number, header.bin_size, header.bin_width, header.bin_offset,
+                     [values](size_t i) { return __builtin_bswap32(values[i]); }, values);
+        ++frame_sequence_;
 
-    // Setters
-    void set_bin_edge(size_t index, double value) {
-        if (index >= bin_edges_.size()) {
-            throw std::out_of_range("Bin edge index out of range");
-        }
-        bin_edges_[index] = value;
+        request_outputs();
     }
 
-    void set_bin_value_32(size_t index, uint32_t value) {
-        if (data_type_ != DataType::FRAME_DATA || index >= bin_values_32_.size()) {
-            throw std::out_of_range("Invalid index or data type for 32-bit access");
-        }
-        bin_values_32_[index] = value;
+    /**
+     * @brief Staging state of the running sum, for statistics (nullptr if none exists)
+     */
+    const StagedSum* get_staged_sum() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return running_sum_.get();
     }
 
-    void set_bin_value_64(size_t index, uint64_t value) {
-        if (data_type_ != DataType::RUNNING_SUM || index >= bin_values_64_.size()) {
-            throw std::out_of_range("Invalid index or data type for 64-bit access");
-        }
-        bin_values_64_[index] = value;
-    }
+    // Frames mapped onto the running sum's grid, whole counts that fell outside it,
+    // and running sums started over because of a grid change
+    uint64_t rebinned_frames() const { return rebinned_frames_ + (rebinner_ ? rebinner_->frames_rebinned() : 0); }
+    uint64_t rebin_dropped_counts() const { return dropped_counts_ + (rebinner_ ? rebinner_->dropped_counts() : 0); }
+    size_t grid_restarts() const { return grid_restarts_; }
 
-    // Calculate bin edges from parameters
-    void calculate_bin_edges(int bin_width, int bin_offset) {
-        for (size_t i = 0; i < bin_edges_.size(); ++i) {
-            bin_edges_[i] = (bin_offset + (i * bin_width)) * TPX3_TDC_CLOCK_PERIOD_SEC;
-        }
+    /**
+     * @brief Sliding-window sum (nullptr unless enabled and a frame has arrived)
+     */
+    const SlidingWindowSum* get_window_sum() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return window_.get();
     }
 
-    // Add another histogram to this one (for running sum)
-    void add_histogram(const HistogramData& other) {
-        if (other.data_type_ != DataType::FRAME_DATA || data_type_ != DataType::RUNNING_SUM) {
-            throw std::invalid_argument("Can only add frame data to running sum");
-        }
-        
-        if (other.bin_size_ != bin_size_) {
-            throw std::invalid_argument("Bin sizes must match for addition");
+    /**
+     * @brief Drop the slots of a time window that ended by now and rewrite its file if that changed it
+     *
+     * Called while no frames arrive; otherwise the window only moves when a frame is added.
+     */
+    void expire_window(SlidingWindowSum::Clock::time_point now) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (window_ && window_->advance_to(now)) {
+            writer_.refresh();
         }
+    }
 
-        for (size_t i = 0; i < bin_size_; ++i) {
-            uint64_t new_value = bin_values_64_[i] + other.bin_values_32_[i];
-            if (new_value < bin_values_64_[i]) {
-                std::cerr << "Warning: Overflow detected in bin " << i 
-                          << ", capping at maximum value" << std::endl;
-                bin_values_64_[i] = UINT64_MAX;
-            } else {
-                bin_values_64_[i] = new_value;
+    /**
+     * @brief Bring all output files up to date: the last checkpoint and the waterfall
+     */
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // The row being filled goes into the final dump
+            if (waterfall_builder_ && waterfall_builder_->has_row()) {
+                waterfall_rows_.push_back({waterfall_serial_, waterfall_builder_->shared_axis(),
+                                           waterfall_builder_->take_row()});
+                writer_.refresh();
             }
         }
+        writer_.flush();
+        if (shm_writer_) {
+            shm_writer_->flush();
+        }
     }
 
-private:
-    size_t bin_size_;
-    DataType data_type_;
-    std::vector<double> bin_edges_;
-    std::vector<uint32_t> bin_values_32_;
-    std::vector<uint64_t> bin_values_64_;
-};
+    const CheckpointWriter& checkpoint_writer() const { return writer_; }
 
-/**
- * @brief Network client for TCP socket communication
- */
-class NetworkClient {
-public:
-    NetworkClient() : socket_fd_(-1), connected_(false) {}
-    
-    ~NetworkClient() {
-        disconnect();
-    }
+    /**
+     * @brief Shared-memory publisher (nullptr unless enabled)
+     */
+    const ShmPublisher* shm_publisher() const { return shm_.get(); }
 
-    // Disable copy
-    NetworkClient(const NetworkClient&) = delete;
-    NetworkClient& operator=(const NetworkClient&) = delete;
+    /**
+     * @brief Waterfall rows written so far (nullptr unless enabled and a row was written)
+     *
+     * Owned by the checkpoint writer; only read it after finish().
+     */
+    const Waterfall* get_waterfall() const { return waterfall_.get(); }
 
-    // Allow move
-    NetworkClient(NetworkClient&& other) noexcept
-        : socket_fd_(other.socket_fd_), connected_(other.connected_) {
-        other.socket_fd_ = -1;
-        other.connected_ = false;
+    /**
+     * @brief Decayed sum (nullptr unless enabled and a frame has arrived)
+     */
+    const DecayedSum* get_decayed_sum() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return decayed_.get();
     }
 
-    NetworkClient& operator=(NetworkClient&& other) noexcept {
-        if (this != &other) {
-            disconnect();
-            socket_fd_ = other.socket_fd_;
-            connected_ = other.connected_;
-            other.socket_fd_ = -1;
-            other.connected_ = false;
+private:
+    /**
+     * @brief Wake the checkpoint writer and the shared-memory publisher
+     */
+    void request_outputs() {
+        writer_.request(frame_sequence_);
+        if (shm_writer_) {
+            shm_writer_->request(frame_sequence_);
         }
-        return *this;
     }
 
     /**
-     * @brief Connect to server
-     * @param host Server hostname/IP
-     * @param port Server port
-     * @return true if successful, false otherwise
+     * @brief Task of the shared-memory publisher thread: copy the sum straight into the segment
+     * @return Frames the snapshot covers
+     *
+     * Runs under the lock like a checkpoint capture, but the segment is the
+     * only copy; the shm interval bounds how often the accumulation thread
+     * waits for it. Readers never hold anything up: see ShmPublisher.
      */
-    bool connect(const std::string& host, int port) {
-        socket_fd_ = socket(AF_INET, SOCK_STREAM, 0);
-        if (socket_fd_ < 0) {
-            std::cerr << "Socket creation failed: " << strerror(errno) << std::endl;
-            return false;
+    uint64_t publish_shm() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t frames = static_cast<uint64_t>(frame_sequence_);
+        if (running_sum_) {
+            const StagedSum& sum = *running_sum_;
+            try {
+                shm_->publish(sum.axis(), frames, [&sum](uint64_t* counts) { sum.copy_values(counts); });
+            } catch (const std::exception& e) {
+                std::cerr << "Failed to publish to shared memory: " << e.what() << std::endl;
+            }
         }
+        return frames;
+    }
 
-        // Set TCP_NODELAY to disable Nagle's algorithm
-        int flag = 1;
-        if (setsockopt(socket_fd_, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag)) < 0) {
-            std::cerr << "Failed to set TCP_NODELAY: " << strerror(errno) << std::endl;
+    /**
+     * @brief Copy of one histogram, taken under the lock and written outside of it
+     */
+    template <typename T>
+    struct Capture {
+        bool present = false;
+        BinAxis axis{0, 1, 0};
+        std::vector<T> values;
+
+        // Bulk copy (memcpy or one pass per chunk), as the snapshot writers do
+        template <typename View>
+        void take(const View* view) {
+            present = view != nullptr;
+            if (present) {
+                axis = view->axis();
+                values.resize(axis.bin_count());
+                view->copy_values(values.data());
+            }
         }
 
-        // Set larger socket buffers
-        int rcvbuf = 256 * 1024;  // 256KB receive buffer
-        if (setsockopt(socket_fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) < 0) {
-            std::cerr << "Failed to set receive buffer size: " << strerror(errno) << std::endl;
+        void save(const HistogramProcessor& processor, const std::string& filename, uint64_t generation,
+                  std::vector<char>& buffer) const {
+            if (present) {
+                processor.save_histogram_to_file(filename, axis, [this](size_t i) { return values[i]; },
+                                                 generation, buffer);
+            }
         }
+    };
 
-        struct sockaddr_in server_addr{};
-        server_addr.sin_family = AF_INET;
-        server_addr.sin_port = htons(port);
-        
-        if (inet_pton(AF_INET, host.c_str(), &server_addr.sin_addr) <= 0) {
-            std::cerr << "Invalid address: " << host << std::endl;
-            close(socket_fd_);
-            socket_fd_ = -1;
-            return false;
-        }
+    /**
+     * @brief Running sum replaced on a grid change, waiting to be saved by the writer thread
+     */
+    struct Archive {
+        std::string path;
+        std::unique_ptr<StagedSum> sum;
+    };
+
+    /**
+     * @brief Completed waterfall row, waiting to be added to the ring by the writer thread
+     */
+    struct PendingRow {
+        uint64_t serial;  // Rows of a new serial start a new ring (the grid changed)
+        std::shared_ptr<const BinAxis> axis;
+        WaterfallRow row;
+    };
 
-        std::cout << "Attempting to connect to " << host << ":" << port << "..." << std::endl;
-        
-        if (::connect(socket_fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-            std::cerr << "Connection failed: " << strerror(errno) << std::endl;
-            close(socket_fd_);
-            socket_fd_ = -1;
-            return false;
+    /**
+     * @brief Checkpoint task of the writer thread: capture under the lock, write outside it
+     * @return Frames the checkpoint covers
+     */
+    uint64_t write_checkpoint() {
+        uint64_t frames = 0;
+        std::vector<Archive> archives;
+        std::vector<PendingRow> rows;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            frames = static_cast<uint64_t>(frame_sequence_);
+            archives.swap(archives_);
+            rows.swap(waterfall_rows_);
+            sum_capture_.take(running_sum_.get());
+            if (window_) {
+                window_->advance_to(SlidingWindowSum::Clock::now());
+            }
+            window_capture_.take(window_.get());
+            decayed_capture_.take(decayed_.get());
+        }
+        for (const Archive& archive : archives) {
+            const StagedSum& sum = *archive.sum;
+            save_histogram_to_file(archive.path, sum.axis(), [&sum](size_t i) { return sum.value(i); }, 0,
+                                   text_buffer_);
+            std::cerr << "Bin grid changed, previous running sum saved to " << archive.path << std::endl;
+        }
+        // Files written from one capture share a generation number
+        ++generation_;
+        uint64_t text_generation = generation_header_ ? generation_ : 0;
+        if (formats_.text) {
+            sum_capture_.save(*this, output_path_, text_generation, text_buffer_);
         }
-        
-        std::cout << "Connected successfully" << std::endl;
-        connected_ = true;
-        return true;
+        if (sum_capture_.present && (formats_.binary || formats_.npy)) {
+            save_binary_snapshots(sum_capture_, frames);
+        }
+        window_capture_.save(*this, derived_output_path("window"), text_generation, text_buffer_);
+        decayed_capture_.save(*this, derived_output_path("decayed"), text_generation, text_buffer_);
+        if (!rows.empty()) {
+            write_waterfall(rows);
+        }
+        return frames;
     }
 
     /**
-     * @brief Disconnect from server
+     * @brief Add completed rows to the ring and rewrite <output>-waterfall.bin (writer thread)
      */
-    void disconnect() {
-        if (socket_fd_ >= 0) {
-            close(socket_fd_);
-            socket_fd_ = -1;
+    void write_waterfall(const std::vector<PendingRow>& rows) {
+        for (const PendingRow& pending : rows) {
+            if (!waterfall_ || pending.serial != waterfall_serial_written_) {
+                waterfall_ = std::make_unique<Waterfall>(pending.axis, waterfall_spec_);
+                waterfall_serial_written_ = pending.serial;
+            }
+            waterfall_->push(pending.row);
+        }
+        std::filesystem::path path(output_path_);
+        std::string dump = (path.parent_path() / path.stem()).string() + "-waterfall.bin";
+        if (!waterfall_->dump(dump)) {
+            std::cerr << "Failed to write waterfall: " << dump << std::endl;
         }
-        connected_ = false;
     }
 
     /**
-     * @brief Check if connected
-     * @return true if connected
+     * @brief Write the running sum as <output>.tpx3h and/or <output>.npy, counts straight from memory
      */
-    bool is_connected() const { return connected_; }
+    void save_binary_snapshots(const Capture<uint64_t>& sum, uint64_t frames) const {
+        std::filesystem::path path(output_path_);
+        std::string stem = (path.parent_path() / path.stem()).string();
+        Span<const char> counts = as_bytes(sum.values.data(), sum.values.size());
+        if (formats_.binary) {
+            BinarySnapshotHeader header = BinarySnapshotHeader::make(sum.axis, frames, generation_);
+            write_file_atomically(stem + ".tpx3h", {as_bytes(&header, 1), counts});
+        }
+        if (formats_.npy) {
+            std::string header = npy_header(sum.values.size(), "<u8");
+            write_file_atomically(stem + ".npy", {Span<const char>(header.data(), header.size()), counts});
+        }
+    }
 
     /**
-     * @brief Receive data from socket
-     * @param buffer Buffer to store received data
-     * @param max_size Maximum size to receive
-     * @return Number of bytes received, -1 on error, 0 on connection closed
+     * @brief Make the running sum ready for a frame on the given grid
+     * @return Table to rebin the frame through, or nullptr to add it directly
+     *
+     * The first frame fixes the running sum's grid. Later frames on another
+     * grid are rebinned onto it, unless the policy is RESTART or the grids do
+     * not overlap at all; then the current sum is archived and a new one starts
+     * on the frame's grid.
      */
-    ssize_t receive(char* buffer, size_t max_size) {
-        if (!connected_ || socket_fd_ < 0) {
-            return -1;
+    const RebinTable* prepare_running_sum(size_t bin_count, int bin_width, int bin_offset) {
+        if (running_sum_ && running_sum_->axis().matches(bin_count, bin_width, bin_offset)) {
+            return nullptr;
         }
-        
-        ssize_t bytes_read = recv(socket_fd_, buffer, max_size, 0);
-        
-        if (bytes_read == 0) {
-            std::cout << "Connection closed by peer" << std::endl;
-            connected_ = false;
-        } else if (bytes_read < 0) {
-            if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                std::cerr << "Socket error: " << strerror(errno) << std::endl;
-                connected_ = false;
+        if (running_sum_ && grid_policy_ == GridChangePolicy::REBIN) {
+            if (!rebinner_) {
+                rebinner_ = std::make_unique<Rebinner>(running_sum_->shared_axis());
+            }
+            if (!rebinner_->can_rebin(bin_width)) {
+                std::cerr << "Bin grid changed to binWidth " << bin_width << " (running sum binWidth "
+                          << running_sum_->axis().bin_width() << "), which cannot be rebinned, starting a new "
+                          << "running sum" << std::endl;
+            } else {
+                uint64_t built = rebinner_->tables_built();
+                const RebinTable& table = rebinner_->table(bin_count, bin_width, bin_offset);
+                if (!table.disjoint()) {
+                    if (rebinner_->tables_built() != built) {
+                        std::cerr << "Bin grid changed (binSize " << bin_count << ", binWidth " << bin_width
+                                  << ", binOffset " << bin_offset << "), rebinning onto the running sum's grid ("
+                                  << table.dropped_bins() + table.partial_bins() << " bins partly outside it)"
+                                  << std::endl;
+                    }
+                    return &table;
+                }
+                std::cerr << "Bin grid changed and does not overlap the running sum, starting a new one"
+                          << std::endl;
             }
         }
-        
-        return bytes_read;
+
+        if (running_sum_) {
+            archive_running_sum();
+        }
+        running_sum_ = std::make_unique<StagedSum>(
+            std::make_shared<const BinAxis>(bin_count, bin_width, bin_offset));
+        return nullptr;
     }
 
     /**
-     * @brief Receive exact amount of data
-     * @param buffer Buffer to store received data
-     * @param size Exact size to receive
-     * @return true if successful, false otherwise
+     * @brief Add a frame to the sliding-window, decayed and waterfall views, which follow the latest grid
+     * @param frame_number Frame number from the header (the waterfall's row key)
+     * @param count_at count_at(i) is the count of bin i
+     * @param wire The same counts as received (network byte order)
      */
-    bool receive_exact(char* buffer, size_t size) {
-        size_t total_received = 0;
-        
-        while (total_received < size) {
-            ssize_t bytes = receive(buffer + total_received, size - total_received);
-            
-            if (bytes <= 0) {
-                return false;
+    template <typename CountAt>
+    void add_to_views(int64_t frame_number, size_t bin_count, int bin_width, int bin_offset,
+                      const CountAt& count_at, const uint32_t* wire) {
+        if (window_spec_.enabled()) {
+            if (!window_ || !window_->axis().matches(bin_count, bin_width, bin_offset)) {
+                window_ = std::make_unique<SlidingWindowSum>(
+                    view_axis(bin_count, bin_width, bin_offset), window_spec_);
             }
-            
-            total_received += bytes;
+            window_->add_be32(wire, bin_count);
         }
-        
-        return true;
-    }
-
-private:
-    int socket_fd_;
-    bool connected_;
-};
-
-/**
- * @brief Processes histogram data and maintains running sum
- */
-class HistogramProcessor {
-public:
-    HistogramProcessor() = default;
-    
-    ~HistogramProcessor() = default;
 
-    // Disable copy
-    HistogramProcessor(const HistogramProcessor&) = delete;
-    HistogramProcessor& operator=(const HistogramProcessor&) = delete;
+        if (decay_alpha_ > 0.0) {
+            if (!decayed_ || !decayed_->axis().matches(bin_count, bin_width, bin_offset)) {
+                decayed_ = std::make_unique<DecayedSum>(
+                    view_axis(bin_count, bin_width, bin_offset), decay_alpha_);
+            }
+            decayed_->add_be32(wire, bin_count);
+        }
 
-    // Allow move
-    HistogramProcessor(HistogramProcessor&&) = default;
-    HistogramProcessor& operator=(HistogramProcessor&&) = default;
+        if (waterfall_spec_.enabled()) {
+            if (!waterfall_builder_ || !waterfall_builder_->axis().matches(bin_count, bin_width, bin_offset)) {
+                try {
+                    waterfall_builder_ = std::make_unique<WaterfallBuilder>(
+                        view_axis(bin_count, bin_width, bin_offset), waterfall_spec_);
+                } catch (const std::length_error& e) {
+                    std::cerr << "Waterfall disabled: " << e.what()
+                              << "; lower --waterfall-rows or raise --waterfall-max-mb" << std::endl;
+                    waterfall_builder_.reset();
+                    waterfall_spec_ = WaterfallSpec{};
+                    return;
+                }
+                ++waterfall_serial_;
+            }
+            // A completed row is handed to the writer thread, which rewrites the dump
+            WaterfallRow completed;
+            if (waterfall_builder_->add(frame_number, bin_count, count_at, completed)) {
+                waterfall_rows_.push_back({waterfall_serial_, waterfall_builder_->shared_axis(),
+                                           std::move(completed)});
+            }
+        }
+    }
 
     /**
-     * @brief Process a new frame of histogram data
-     * @param frame_data Frame histogram data
+     * @brief Axis for a view, shared with the running sum when the grids match
      */
-    void process_frame(const HistogramData& frame_data) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        if (!running_sum_) {
-            // Initialize running sum with same bin size
-            running_sum_ = std::make_unique<HistogramData>(
-                frame_data.get_bin_size(), 
-                HistogramData::DataType::RUNNING_SUM
-            );
-            
-            // Copy bin edges
-            for (size_t i = 0; i < frame_data.get_bin_edges().size(); ++i) {
-                running_sum_->set_bin_edge(i, frame_data.get_bin_edges()[i]);
-            }
+    std::shared_ptr<const BinAxis> view_axis(size_t bin_count, int bin_width, int bin_offset) const {
+        if (running_sum_->axis().matches(bin_count, bin_width, bin_offset)) {
+            return running_sum_->shared_axis();
         }
-        
-        // Add frame data to running sum
-        running_sum_->add_histogram(frame_data);
-        
-        // Save updated running sum
-        save_running_sum();
+        return std::make_shared<const BinAxis>(bin_count, bin_width, bin_offset);
     }
 
     /**
-     * @brief Get current running sum
-     * @return Pointer to running sum histogram (nullptr if none exists)
+     * @brief Output path with a suffix before the extension, e.g. <output>-window.txt
      */
-    const HistogramData* get_running_sum() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return running_sum_.get();
+    std::string derived_output_path(const std::string& suffix) const {
+        std::filesystem::path path(output_path_);
+        return (path.parent_path() / path.stem()).string() + "-" + suffix + path.extension().string();
     }
 
     /**
-     * @brief Save running sum to file
+     * @brief Hand the finished running sum to the writer thread as <output>-grid<N>; a new one must follow
      */
-    void save_running_sum() {
-        if (!running_sum_) {
-            return;
+    void archive_running_sum() {
+        ++grid_restarts_;
+        // The old sum is not touched again; the writer thread saves it outside the lock
+        archives_.push_back({derived_output_path("grid" + std::to_string(grid_restarts_)), std::move(running_sum_)});
+
+        if (rebinner_) {
+            rebinned_frames_ += rebinner_->frames_rebinned();
+            dropped_counts_ += rebinner_->dropped_counts();
+            rebinner_.reset();
         }
-        
-        std::string filename = "data/tof-histogram-running-sum.txt";
-        save_histogram_to_file(filename, *running_sum_);
     }
 
-private:
+    static void warn_overflow() {
+        std::cerr << "Warning: Overflow detected, capping affected bins at maximum value"
+                  << std::endl;
+    }
+
     /**
      * @brief Save histogram data to file
      * @param filename Output filename
-     * @param histogram Histogram data to save
+     * @param axis Bin axis of the histogram
+     * @param count_at count_at(i) is the count of bin i (staged counts included, not flushed)
+     * @param generation Written as a "# Generation:" header line unless 0
+     * @param buffer Reused text buffer (see text_format::format_histogram)
+     *
+     * The text is rendered into buffer and written with one write() (see
+     * write_file_atomically, so readers never see a partial file).
      */
-    void save_histogram_to_file(const std::string& filename, const HistogramData& histogram) {
-        std::ofstream file(filename);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open file: " << filename << std::endl;
-            return;
-        }
-
-        // Set larger buffer for file I/O
-        file.rdbuf()->pubsetbuf(nullptr, 0);  // Use default buffering
+    template <typename CountAt>
+    void save_histogram_to_file(const std::string& filename, const BinAxis& axis,
+                                const CountAt& count_at, uint64_t generation,
+                                std::vector<char>& buffer) const {
+        size_t length = text_format::format_histogram(buffer, axis, count_at, generation);
 
-        file << "# Time of Flight Histogram Data\n";
-        file << "# Bins: " << histogram.get_bin_size() << "\n";
-        file << "#\n";
-
-        for (size_t i = 0; i < histogram.get_bin_size(); ++i) {
-            if (histogram.get_data_type() == HistogramData::DataType::RUNNING_SUM) {
-                file << std::scientific << std::setprecision(9) 
-                     << histogram.get_bin_edges()[i] << "\t" 
-                     << histogram.get_bin_value_64(i) << "\n";
-            } else {
-                file << std::scientific << std::setprecision(9) 
-                     << histogram.get_bin_edges()[i] << "\t" 
-                     << histogram.get_bin_value_32(i) << "\n";
-            }
-        }
-        
-        // Write last bin edge
-        file << std::scientific << std::setprecision(9) 
-             << histogram.get_bin_edges()[histogram.get_bin_size()] << "\n";
-        
-        file.close();
+        write_file_atomically(filename, {Span<const char>(buffer.data(), length)});
     }
 
+    std::string output_path_;
+    WorkerPool* workers_;
+    GridChangePolicy grid_policy_;
+    WindowSpec window_spec_;
+    double decay_alpha_;
+    WaterfallSpec waterfall_spec_;
+    bool generation_header_;
+    OutputFormats formats_;
     mutable std::mutex mutex_;
-    std::unique_ptr<HistogramData> running_sum_;
+    std::unique_ptr<StagedSum> running_sum_;
+    std::unique_ptr<Rebinner> rebinner_;  // Created on the first frame on another grid
+    std::unique_ptr<SlidingWindowSum> window_;
+    std::unique_ptr<DecayedSum> decayed_;
+    std::unique_ptr<WaterfallBuilder> waterfall_builder_;
+    uint64_t waterfall_serial_ = 0;       // Bumped whenever the waterfall restarts on a new grid
+    int64_t frame_sequence_ = 0;          // Frames seen; row key for frames without a header
+    uint64_t rebinned_frames_ = 0;        // Totals of rebinners of archived sums
+    uint64_t dropped_counts_ = 0;
+    size_t grid_restarts_ = 0;
+    std::vector<Archive> archives_;       // Handed to the writer thread at the next checkpoint
+    std::vector<PendingRow> waterfall_rows_;  // Likewise
+    // Used by the writer thread only
+    uint64_t generation_ = 0;
+    std::vector<char> text_buffer_;
+    Capture<uint64_t> sum_capture_;
+    Capture<uint64_t> window_capture_;
+    Capture<double> decayed_capture_;
+    std::unique_ptr<Waterfall> waterfall_;
+    uint64_t waterfall_serial_written_ = 0;
+    CheckpointWriter writer_;             // Its thread uses the members above
+    std::unique_ptr<ShmPublisher> shm_;
+    std::unique_ptr<CheckpointWriter> shm_writer_;  // Last: its thread uses shm_ and the members above
+};
+
+/**
+ * @brief Command line configuration of the application
+ */
+struct AppConfig {
+    std::vector<SourceEndpoint> sources;
+    size_t queue_capacity = DEFAULT_QUEUE_CAPACITY;
+    ReconnectPolicy reconnect;
+    bool combined = false;  // Also keep a sum over all sources
+    IngestBackend backend = IngestBackend::RECV;
+    bool quiet = false;     // Skip the per-frame printout
+    std::string record_path;                   // Tee received bytes to this file
+    std::shared_ptr<RecordingReader> replay;   // Replay this recording instead of connecting
+    bool replay_paced = false;                 // Reproduce the recorded timing
+    size_t accumulate_threads = default_worker_threads();  // Threads per running-sum addition
+    GridChangePolicy grid_policy = GridChangePolicy::REBIN;
+    WindowSpec window;
+    double decay_alpha = 0.0;
+    DecayOutputs decay_outputs = DecayOutputs::ALL;
+    WaterfallSpec waterfall;
+    std::chrono::milliseconds checkpoint_interval{0};
+    bool generation_header = false;
+    OutputFormats formats;
+    std::string shm_name;  // Publish running sums to shared memory under this name
+    std::chrono::milliseconds shm_interval{DEFAULT_SHM_INTERVAL_MS};
 };
 
 /**
  * @brief Main application class
+ *
+ * A receive thread runs an IngestLoop over all configured servers and pushes
+ * complete frames into a bounded SPSC ring; an accumulation thread drains the
+ * ring, converts, prints and adds each frame to its source's running sum (and
+ * the combined sum, if enabled). Output files are written by each processor's
+ * checkpoint writer thread, so a slow disk neither stalls recv() nor the
+ * accumulator.
+ *
+ * Each source has its own StreamFramer, which pulls every complete frame out
+ * of each recv() in one pass. Payloads land in buffers from a FramePool and
+ * travel through the queue by pointer, so steady-state frames allocate nothing.
+ *
+ * Connections are supervised: when a server goes away the loop reconnects
+ * with exponential backoff and keeps accumulating into the same running sum.
  */
 class TPX3HistogramApp {
 public:
-    TPX3HistogramApp() = default;
+    explicit TPX3HistogramApp(const AppConfig& config)
+        : config_(config),
+          workers_(config.accumulate_threads),
+          frame_queue_(config.queue_capacity),
+          // One buffer per queue slot plus the ones held by each thread
+          frame_pool_(frame_queue_.capacity() + 1 + config.sources.size(), POOL_INITIAL_BINS) {
+        bool single = config_.sources.size() == 1;
+        for (const auto& endpoint : config_.sources) {
+            ProcessorOptions options = processor_options(false);
+            if (!config_.shm_name.empty() && !single) {
+                options.shm_name = config_.shm_name + "-" + endpoint.host + "-" + std::to_string(endpoint.port);
+            }
+            processors_.push_back(std::make_unique<HistogramProcessor>(
+                single ? DEFAULT_OUTPUT_PATH : source_output_path(endpoint), options));
+        }
+        if (config_.combined && !single) {
+            combined_ = std::make_unique<HistogramProcessor>(DEFAULT_OUTPUT_PATH, processor_options(true));
+        }
+    }
     
     ~TPX3HistogramApp() = default;
 
@@ -478,194 +621,533 @@ public:
     TPX3HistogramApp& operator=(const TPX3HistogramApp&) = delete;
 
     /**
-     * @brief Run the application
-     * @param host Server hostname/IP
-     * @param port Server port
+     * @brief Run the application until all sources finish or a stop is requested
      * @return Exit code
      */
-    int run(const std::string& host = DEFAULT_HOST, int port = DEFAULT_PORT) {
+    int run() {
         // Create data directory
         std::filesystem::create_directories("data");
-        
-        // Connect to server
-        if (!client_.connect(host, port)) {
-            return 1;
-        }
 
-        std::cout << "Waiting for data..." << std::endl;
-        
-        std::vector<char> line_buffer(MAX_BUFFER_SIZE);
-        size_t total_read = 0;
+        receive_done_ = false;
+        std::thread accumulator(&TPX3HistogramApp::accumulation_loop, this);
+        std::thread receiver(&TPX3HistogramApp::receive_loop, this);
 
-        try {
-            while (client_.is_connected()) {
-                ssize_t bytes_read = client_.receive(
-                    line_buffer.data() + total_read, 
-                    MAX_BUFFER_SIZE - total_read - 1
-                );
-
-                if (bytes_read <= 0) {
-                    break;
-                }
+        receiver.join();
+        accumulator.join();
+        for (auto& processor : processors_) {
+            processor->finish();
+        }
+        if (combined_) {
+            combined_->finish();
+        }
 
-                total_read += bytes_read;
-                line_buffer[total_read] = '\0';
-                
-                // Look for newline
-                char* newline_pos = static_cast<char*>(memchr(line_buffer.data(), '\n', total_read));
-                if (newline_pos) {
-                    *newline_pos = '\0';
-                    
-                    // Process complete line
-                    if (!process_data_line(line_buffer.data(), newline_pos, total_read)) {
-                        break;
-                    }
-                    
-                    // Move remaining data to start of buffer
-                    size_t remaining = total_read - (newline_pos - line_buffer.data() + 1);
-                    if (remaining > 0) {
-                        memmove(line_buffer.data(), newline_pos + 1, remaining);
-                    }
-                    total_read = remaining;
-                }
-                
-                // Prevent buffer overflow
-                if (total_read >= MAX_BUFFER_SIZE - 1) {
-                    std::cout << "Buffer full, resetting" << std::endl;
-                    total_read = 0;
-                }
+        std::cout << "Frame queue: capacity " << frame_queue_.capacity()
+                  << ", high-water mark " << frame_queue_.high_water_mark()
+                  << ", producer stalls " << queue_full_stalls_
+                  << ", pool stalls " << pool_stalls_ << std::endl;
+        std::cout << "Accumulate kernel: " << accumulate_kernel_name() << ", "
+                  << workers_.thread_count() << " thread(s)" << std::endl;
+        if (const StagedSum* staged = processors_.front()->get_staged_sum()) {
+            std::cout << "Running sum storage: " << staged->chunk_count() << " chunk(s) of "
+                      << HUGE_PAGE_SIZE / 1024 << " KiB, "
+                      << staged->sum().storage().explicit_huge_pages()
+                      << " on reserved huge pages; 32-bit staging (" << stage_kernel_name() << ") flushed "
+                      << staged->flushes() << " times, " << staged->carries() << " carries" << std::endl;
+        }
+        if (const SlidingWindowSum* window = processors_.front()->get_window_sum()) {
+            std::cout << "Sliding window: " << window->frames_in_window() << " frames in "
+                      << window->slot_count() << " slots" << std::endl;
+        }
+        if (const ShmPublisher* shm = processors_.front()->shm_publisher()) {
+            std::cout << "Shared memory: " << shm->name() << ", " << shm->publishes() << " snapshots published"
+                      << std::endl;
+        }
+        const CheckpointWriter& writer = processors_.front()->checkpoint_writer();
+        std::cout << "Checkpoints: " << writer.writes() << " written for " << writer.requests()
+                  << " frames, at most " << writer.max_frames_behind() << " frames behind" << std::endl;
+        if (const Waterfall* waterfall = processors_.front()->get_waterfall()) {
+            std::cout << "Waterfall: " << waterfall->row_count() << " of " << waterfall->rows_started()
+                      << " rows kept (capacity " << waterfall->capacity() << ")" << std::endl;
+        }
+        if (config_.decay_alpha > 0.0) {
+            std::cout << "Decayed sum: alpha " << config_.decay_alpha << ", " << DecayedSum::kernel_name()
+                      << " kernel" << std::endl;
+        }
+        std::cout << "Frame pool: " << frame_pool_.buffer_count() << " buffers, "
+                  << frame_pool_.allocations() << " payload allocations ("
+                  << frame_pool_.regrowths() << " regrowths, "
+                  << frame_pool_.reserved_bytes() / (1024 * 1024) << " MiB reserved) for "
+                  << frames_processed_ << " frames" << std::endl;
+        if (frames_processed_ > 1) {
+            double seconds = std::chrono::duration<double>(last_frame_time_ - first_frame_time_).count();
+            std::cout << "Processed " << frames_processed_ << " frames in " << seconds << " s ("
+                      << static_cast<uint64_t>((frames_processed_ - 1) / seconds) << " frames/s)"
+                      << std::endl;
+        }
+        for (size_t i = 0; i < source_stats_.size(); ++i) {
+            const SourceStats& stats = source_stats_[i];
+            std::cout << "Source " << config_.sources[i].label() << ": " << stats.frames
+                      << " frames, " << stats.reconnects << " reconnects, "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(stats.downtime).count()
+                      << " ms downtime";
+            if (stats.resyncs > 0) {
+                std::cout << ", " << stats.resyncs << " resyncs, " << stats.skipped_bytes
+                          << " bytes skipped, " << stats.lost_frames << " frames lost";
             }
-        } catch (const std::exception& e) {
-            std::cerr << "Error: " << e.what() << std::endl;
-            return 1;
+            const HistogramProcessor& processor = *processors_[i];
+            if (processor.rebinned_frames() > 0 || processor.grid_restarts() > 0) {
+                std::cout << ", " << processor.rebinned_frames() << " frames rebinned ("
+                          << processor.rebin_dropped_counts() << " counts outside the grid), "
+                          << processor.grid_restarts() << " grid restarts";
+            }
+            std::cout << std::endl;
+        }
+
+        if (exit_code_ != 0) {
+            return exit_code_;
         }
 
         std::cout << "\n*** Ready ***" << std::endl;
         return 0;
     }
 
+    /**
+     * @brief Current number of frames waiting for the accumulator
+     */
+    size_t queue_depth() const { return frame_queue_.size(); }
+
+    /**
+     * @brief Largest queue depth observed so far
+     */
+    size_t queue_high_water_mark() const { return frame_queue_.high_water_mark(); }
+
 private:
     /**
-     * @brief Process a complete data line
-     * @param line_buffer Buffer containing the line
-     * @param newline_pos Position of newline character
-     * @param total_read Total bytes read so far
-     * @return true if successful, false to exit
+     * @param combined Options for the combined sum rather than a per-source one
      */
-    bool process_data_line(char* line_buffer, char* newline_pos, size_t total_read) {
-        // Skip empty lines
-        if (strlen(line_buffer) == 0) {
-            return true;
+    ProcessorOptions processor_options(bool combined) {
+        ProcessorOptions options;
+        options.workers = &workers_;
+        options.grid_policy = config_.grid_policy;
+        options.window = config_.window;
+        options.waterfall = config_.waterfall;
+        options.checkpoint_interval = config_.checkpoint_interval;
+        options.generation_header = config_.generation_header;
+        options.formats = config_.formats;
+        options.shm_name = config_.shm_name;  // Per-source names are set by the caller
+        options.shm_interval = config_.shm_interval;
+        if (combined && config_.waterfall.frames > 0) {
+            // Frame numbers of different sources do not line up; merged streams only get time rows
+            options.waterfall = WaterfallSpec{};
         }
-        
-        // Parse JSON
-        json j;
+        bool decay = config_.decay_outputs == DecayOutputs::ALL ||
+                     config_.decay_outputs == (combined ? DecayOutputs::COMBINED : DecayOutputs::SOURCES);
+        options.decay_alpha = decay ? config_.decay_alpha : 0.0;
+        return options;
+    }
+
+    /**
+     * @brief Running-sum file of one source when several are configured
+     */
+    static std::string source_output_path(const SourceEndpoint& endpoint) {
+        return "data/tof-histogram-running-sum-" + endpoint.host + "-" +
+               std::to_string(endpoint.port) + ".txt";
+    }
+
+    /**
+     * @brief Receive thread: run the ingest loop over all sources, or replay a recording
+     */
+    void receive_loop() {
         try {
-            j = json::parse(line_buffer);
-        } catch (const json::parse_error& e) {
-            std::cerr << "JSON parse error: " << e.what() << std::endl;
-            return true;  // Continue processing
+            if (config_.replay) {
+                replay_loop();
+            } else {
+                ingest_loop();
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            exit_code_ = 1;
         }
 
-        try {
-            // Extract header information
-            int frame_number = j["frameNumber"];
-            int bin_size = j["binSize"];
-            int bin_width = j["binWidth"];
-            int bin_offset = j["binOffset"];
-
-            // Create frame histogram
-            HistogramData frame_histogram(bin_size, HistogramData::DataType::FRAME_DATA);
-            
-            // Calculate bin edges
-            frame_histogram.calculate_bin_edges(bin_width, bin_offset);
-
-            // Read binary data
-            std::vector<uint32_t> tof_bin_values(bin_size);
-            size_t binary_needed = bin_size * sizeof(uint32_t);
-            
-            // Copy any binary data we already have after the newline
-            size_t remaining = total_read - (newline_pos - line_buffer + 1);
-            size_t binary_read = 0;
-            
-            if (remaining > 0) {
-                size_t to_copy = std::min(remaining, binary_needed);
-                memcpy(tof_bin_values.data(), newline_pos + 1, to_copy);
-                binary_read = to_copy;
+        receive_done_.store(true, std::memory_order_release);
+    }
+
+    /**
+     * @brief Receive from the configured servers, optionally recording the raw stream
+     */
+    void ingest_loop() {
+        IngestLoop ingest(frame_pool_, config_.sources, config_.reconnect, MAX_BUFFER_SIZE,
+                          config_.backend);
+
+        std::unique_ptr<StreamRecorder> recorder;
+        if (!config_.record_path.empty()) {
+            std::vector<std::string> labels;
+            for (const auto& endpoint : config_.sources) {
+                labels.push_back(endpoint.label());
+            }
+            recorder = std::make_unique<StreamRecorder>(config_.record_path, labels);
+            ingest.set_receive_tap([&recorder](size_t source, const char* data, size_t length) {
+                recorder->append(source, data, length);
+            });
+        }
+
+        if (!ingest.run(g_stop_requested, [this](FrameBuffer* frame) { enqueue_frame(frame); })) {
+            exit_code_ = 1;
+        }
+
+        std::cout << "Receive backend: " << backend_name(ingest.backend()) << ", "
+                  << ingest.receive_syscalls() << " receive syscalls" << std::endl;
+        if (recorder) {
+            recorder->close();
+            std::cout << "Recorded " << recorder->bytes() << " bytes in " << recorder->chunks()
+                      << " chunks to " << recorder->path() << " (" << recorder->stalls()
+                      << " writer stalls)" << std::endl;
+            if (recorder->failed()) {
+                exit_code_ = 1;
             }
+        }
+
+        pool_stalls_ += ingest.pool_stalls();
+        for (size_t i = 0; i < ingest.source_count(); ++i) {
+            source_stats_.push_back(ingest.stats(i));
+        }
+    }
+
+    /**
+     * @brief Feed a recording through the same framing and accumulation path
+     */
+    void replay_loop() {
+        StreamReplayer replayer(frame_pool_, *config_.replay, MAX_BUFFER_SIZE);
+        if (!replayer.run(g_stop_requested, config_.replay_paced,
+                          [this](FrameBuffer* frame) { enqueue_frame(frame); })) {
+            exit_code_ = 1;
+        }
 
-            // Read any remaining binary data needed
-            if (binary_read < binary_needed) {
-                if (!client_.receive_exact(
-                    reinterpret_cast<char*>(tof_bin_values.data()) + binary_read,
-                    binary_needed - binary_read)) {
-                    
-                    std::cerr << "Failed to read binary data" << std::endl;
-                    return false;
+        double seconds = std::chrono::duration<double>(replayer.elapsed()).count();
+        std::cout << "Replayed " << config_.replay->size() << " bytes in " << seconds << " s ("
+                  << config_.replay->size() / std::max(seconds, 1e-9) / 1e6 << " MB/s)" << std::endl;
+
+        pool_stalls_ += replayer.pool_stalls();
+        for (size_t i = 0; i < replayer.source_count(); ++i) {
+            source_stats_.push_back(replayer.stats(i));
+        }
+    }
+    
+    /**
+     * @brief Accumulation thread: drain the frame queue until the receiver is done
+     */
+    void accumulation_loop() {
+        SpinBackoff backoff;
+        FrameBuffer* frame = nullptr;
+        auto next_window_check = std::chrono::steady_clock::now();
+
+        while (true) {
+            if (frame_queue_.try_pop(frame)) {
+                backoff.reset();
+                if (frames_processed_ == 0) {
+                    first_frame_time_ = std::chrono::steady_clock::now();
                 }
+                process_frame(*frame);
+                last_frame_time_ = std::chrono::steady_clock::now();
+                frame_pool_.release(frame);
+                continue;
             }
 
-            // Convert to little-endian
-            for (int i = 0; i < bin_size; ++i) {
-                tof_bin_values[i] = __builtin_bswap32(tof_bin_values[i]);
-                frame_histogram.set_bin_value_32(i, tof_bin_values[i]);
+            // Re-check the queue after seeing the flag so no frame is left behind
+            if (receive_done_.load(std::memory_order_acquire) && frame_queue_.empty()) {
+                break;
             }
+            if (config_.window.seconds > 0.0) {
+                // Let time windows drain while no frames arrive
+                auto now = std::chrono::steady_clock::now();
+                if (now >= next_window_check) {
+                    for (auto& processor : processors_) {
+                        processor->expire_window(now);
+                    }
+                    if (combined_) {
+                        combined_->expire_window(now);
+                    }
+                    next_window_check = now + std::chrono::milliseconds(WINDOW_IDLE_CHECK_MS);
+                }
+            }
+            backoff.pause();
+        }
+    }
+
+    /**
+     * @brief Hand a complete frame to the accumulation thread
+     * @param frame Pooled frame; ownership passes to the queue
+     */
+    void enqueue_frame(FrameBuffer* frame) {
+        // Back-pressure normally shows up as a pool stall in the framer, since
+        // every queued frame holds a buffer.
+        SpinBackoff backoff;
+        bool stalled = false;
+        while (!frame_queue_.try_push(std::move(frame))) {
+            stalled = true;
+            backoff.pause();
+        }
+        if (stalled) {
+            ++queue_full_stalls_;
+        }
+    }
 
+    /**
+     * @brief Convert, print and accumulate one frame
+     * @param frame Pooled frame taken from the queue
+     */
+    void process_frame(FrameBuffer& frame) {
+        const FrameHeader& header = frame.header;
+        const uint32_t* values = frame.data();  // Network byte order
+
+        try {
             // Print frame information
-            std::cout << "\nFrame " << frame_number << " data:" << std::endl;
-            std::cout << "Bin edges: ";
-            for (int i = 0; i < bin_size + 1; ++i) {
-                std::cout << std::scientific << std::setprecision(9) 
-                          << frame_histogram.get_bin_edges()[i] << " ";
-            }
-            std::cout << "\nBin values: ";
-            for (int i = 0; i < bin_size; ++i) {
-                std::cout << frame_histogram.get_bin_value_32(i) << " ";
+            if (!config_.quiet) {
+                std::cout << "\nFrame " << header.frame_number << " data";
+                if (config_.sources.size() > 1) {
+                    std::cout << " from " << config_.sources[frame.source].label();
+                }
+                std::cout << ":" << std::endl;
+                std::cout << "Bin edges: ";
+                BinAxis axis(header.bin_size, header.bin_width, header.bin_offset);
+                for (int i = 0; i < header.bin_size + 1; ++i) {
+                    std::cout << std::scientific << std::setprecision(9)
+                              << axis.edge(i) << " ";
+                }
+                std::cout << "\nBin values: ";
+                for (int i = 0; i < header.bin_size; ++i) {
+                    std::cout << __builtin_bswap32(values[i]) << " ";
+                }
+                std::cout << "\n" << std::endl;
             }
-            std::cout << "\n" << std::endl;
 
             // Process frame
-            processor_.process_frame(frame_histogram);
-            
-            std::cout << "Frame " << frame_number << " processed (running sum updated)" << std::endl;
+            processors_[frame.source]->process_frame(header, values);
+            if (combined_) {
+                combined_->process_frame(header, values);
+            }
+            ++frames_processed_;
+
+            if (!config_.quiet) {
+                std::cout << "Frame " << header.frame_number << " processed (running sum updated, queue depth "
+                          << frame_queue_.size() << ", high-water " << frame_queue_.high_water_mark()
+                          << ", pool allocations " << frame_pool_.allocations() << ")" << std::endl;
+            }
 
         } catch (const std::exception& e) {
             std::cerr << "Error processing frame: " << e.what() << std::endl;
         }
-
-        return true;
     }
 
-    NetworkClient client_;
-    HistogramProcessor processor_;
+    AppConfig config_;
+    WorkerPool workers_;  // Declared before the processors that point to it
+    std::vector<std::unique_ptr<HistogramProcessor>> processors_;
+    std::unique_ptr<HistogramProcessor> combined_;
+    SpscRing<FrameBuffer*> frame_queue_;
+    FramePool frame_pool_;
+    std::atomic<uint64_t> frames_processed_{0};
+    std::atomic<bool> receive_done_{false};
+    std::atomic<uint64_t> queue_full_stalls_{0};
+    std::atomic<uint64_t> pool_stalls_{0};
+    std::atomic<int> exit_code_{0};
+    // Written by the accumulation thread, read after it has joined
+    std::chrono::steady_clock::time_point first_frame_time_;
+    std::chrono::steady_clock::time_point last_frame_time_;
+    std::vector<SourceStats> source_stats_;
 };
 
+/**
+ * @brief Request a clean shutdown on SIGINT/SIGTERM
+ */
+void handle_stop_signal(int) {
+    g_stop_requested = true;
+}
+
 /**
  * @brief Main function
  */
 int main(int argc, char* argv[]) {
     std::string host = DEFAULT_HOST;
     int port = DEFAULT_PORT;
+    AppConfig config;
 
     // Parse command line arguments
-    for (int i = 1; i < argc; ++i) {
-        std::string arg = argv[i];
-        if (arg == "--host" && i + 1 < argc) {
-            host = argv[++i];
-        } else if (arg == "--port" && i + 1 < argc) {
-            port = std::stoi(argv[++i]);
-        } else if (arg == "--help" || arg == "-h") {
-            std::cout << "Usage: " << argv[0] << " [--host HOST] [--port PORT] [--help]\n"
-                      << "  --host HOST    Server hostname/IP (default: " << DEFAULT_HOST << ")\n"
-                      << "  --port PORT    Server port (default: " << DEFAULT_PORT << ")\n"
-                      << "  --help, -h     Show this help message\n";
-            return 0;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--host" && i + 1 < argc) {
+                host = argv[++i];
+            } else if (arg == "--port" && i + 1 < argc) {
+                port = std::stoi(argv[++i]);
+            } else if (arg == "--source" && i + 1 < argc) {
+                config.sources.push_back(SourceEndpoint::parse(argv[++i]));
+            } else if (arg == "--combined") {
+                config.combined = true;
+            } else if (arg == "--backend" && i + 1 < argc) {
+                config.backend = parse_backend(argv[++i]);
+            } else if (arg == "--record" && i + 1 < argc) {
+                config.record_path = argv[++i];
+            } else if (arg == "--replay" && i + 1 < argc) {
+                config.replay = std::make_shared<RecordingReader>(argv[++i]);
+            } else if (arg == "--replay-paced") {
+                config.replay_paced = true;
+            } else if (arg == "--quiet") {
+                config.quiet = true;
+            } else if (arg == "--queue-size" && i + 1 < argc) {
+                config.queue_capacity = std::stoul(argv[++i]);
+            } else if (arg == "--accumulate-threads" && i + 1 < argc) {
+                config.accumulate_threads = std::max<size_t>(1, std::stoul(argv[++i]));
+            } else if (arg == "--on-grid-change" && i + 1 < argc) {
+                config.grid_policy = parse_grid_change_policy(argv[++i]);
+            } else if (arg == "--window-frames" && i + 1 < argc) {
+                config.window.frames = std::stoul(argv[++i]);
+            } else if (arg == "--window-seconds" && i + 1 < argc) {
+                config.window.seconds = std::stod(argv[++i]);
+            } else if (arg == "--window-slots" && i + 1 < argc) {
+                config.window.slots = std::max<size_t>(1, std::stoul(argv[++i]));
+            } else if (arg == "--decay-alpha" && i + 1 < argc) {
+                config.decay_alpha = std::stod(argv[++i]);
+            } else if (arg == "--decay-outputs" && i + 1 < argc) {
+                config.decay_outputs = parse_decay_outputs(argv[++i]);
+            } else if (arg == "--checkpoint-interval-ms" && i + 1 < argc) {
+                config.checkpoint_interval = std::chrono::milliseconds(std::stoul(argv[++i]));
+            } else if (arg == "--output-formats" && i + 1 < argc) {
+                config.formats = parse_output_formats(argv[++i]);
+            } else if (arg == "--shm" && i + 1 < argc) {
+                config.shm_name = argv[++i];
+            } else if (arg == "--shm-interval-ms" && i + 1 < argc) {
+                config.shm_interval = std::chrono::milliseconds(std::stoul(argv[++i]));
+            } else if (arg == "--generation-header") {
+                config.generation_header = true;
+            } else if (arg == "--waterfall-frames" && i + 1 < argc) {
+                config.waterfall.frames = std::stoull(argv[++i]);
+            } else if (arg == "--waterfall-seconds" && i + 1 < argc) {
+                config.waterfall.seconds = std::stod(argv[++i]);
+            } else if (arg == "--waterfall-rows" && i + 1 < argc) {
+                config.waterfall.rows = std::max<size_t>(1, std::stoul(argv[++i]));
+            } else if (arg == "--waterfall-max-mb" && i + 1 < argc) {
+                config.waterfall.max_bytes = std::stoull(argv[++i]) << 20;
+            } else if (arg == "--no-reconnect") {
+                config.reconnect.enabled = false;
+            } else if (arg == "--reconnect-min-ms" && i + 1 < argc) {
+                config.reconnect.initial_delay = std::chrono::milliseconds(std::stol(argv[++i]));
+            } else if (arg == "--reconnect-max-ms" && i + 1 < argc) {
+                config.reconnect.max_delay = std::chrono::milliseconds(std::stol(argv[++i]));
+            } else if (arg == "--reconnect-attempts" && i + 1 < argc) {
+                config.reconnect.max_attempts = std::stoul(argv[++i]);
+            } else if (arg == "--help" || arg == "-h") {
+                std::cout << "Usage: " << argv[0] << " [--host HOST] [--port PORT] [--source HOST:PORT]...\n"
+                          << "       [--combined] [--backend recv|io_uring] [--queue-size N] [--quiet]\n"
+                          << "       [--accumulate-threads N] [--on-grid-change rebin|restart]\n"
+                          << "       [--window-frames N | --window-seconds T] [--window-slots K]\n"
+                          << "       [--decay-alpha A [--decay-outputs all|sources|combined]]\n"
+                          << "       [--waterfall-frames F | --waterfall-seconds S] [--waterfall-rows R]\n"
+                          << "       [--waterfall-max-mb MB]\n"
+                          << "       [--checkpoint-interval-ms MS] [--generation-header] [--output-formats LIST]\n"
+                          << "       [--shm NAME [--shm-interval-ms MS]]\n"
+                          << "       [--no-reconnect] [--reconnect-min-ms MS] [--reconnect-max-ms MS]\n"
+                          << "       [--reconnect-attempts N] [--record FILE] [--replay FILE [--replay-paced]] [--help]\n"
+                          << "  --host HOST    Server hostname/IP (default: " << DEFAULT_HOST << ")\n"
+                          << "  --port PORT    Server port (default: " << DEFAULT_PORT << ")\n"
+                          << "  --source HOST:PORT  Add a server; repeat for several (overrides --host/--port)\n"
+                          << "  --combined     With several sources, also keep a sum over all of them\n"
+                          << "  --backend NAME Socket receive path: recv or io_uring (default: recv;\n"
+                          << "                 io_uring falls back to recv when unavailable)\n"
+                          << "  --queue-size N Frames buffered between receive and accumulation threads (default: "
+                          << DEFAULT_QUEUE_CAPACITY << ")\n"
+                          << "  --quiet        Only print the summary, not every frame\n"
+                          << "  --accumulate-threads N  Threads that add large frames chunk by chunk (default: "
+                          << config.accumulate_threads << ")\n"
+                          << "  --on-grid-change P  Frames on a new bin grid: rebin onto the running sum's\n"
+                          << "                 grid, or restart a new sum (default: rebin)\n"
+                          << "  --window-frames N    Also write the sum over the last N frames to <output>-window.txt\n"
+                          << "  --window-seconds T   Same, over the last T seconds\n"
+                          << "  --window-slots K     Steps the window advances in (default: "
+                          << config.window.slots << ")\n"
+                          << "  --decay-alpha A      Also write sum = sum * A + frame (0 < A < 1) to <output>-decayed.txt\n"
+                          << "  --decay-outputs O    Outputs that keep the decayed sum: all, sources or combined (default: all)\n"
+                          << "  --waterfall-frames F Also keep one histogram per F frame numbers in <output>-waterfall.bin\n"
+                          << "  --waterfall-seconds S  Same, one histogram per S seconds\n"
+                          << "  --waterfall-rows R   Rows kept; older ones are overwritten (default: "
+                          << config.waterfall.rows << ")\n"
+                          << "  --waterfall-max-mb MB  Limit on rows x bins x 4 bytes (default: "
+                          << (config.waterfall.max_bytes >> 20) << ")\n"
+                          << "  --checkpoint-interval-ms MS  Shortest time between two rewrites of the output files\n"
+                          << "                       (default: 0, as fast as the disk allows)\n"
+                          << "  --generation-header  Number the checkpoints in a \"# Generation: N\" header line\n"
+                          << "  --output-formats LIST  Running-sum files, any of text, binary (.tpx3h) and npy\n"
+                          << "                       (default: text)\n"
+                          << "  --shm NAME           Also publish the running sum to POSIX shared memory /NAME\n"
+                          << "                       (/NAME-HOST-PORT per source with several sources)\n"
+                          << "  --shm-interval-ms MS Shortest time between two shared-memory publishes (default: "
+                          << DEFAULT_SHM_INTERVAL_MS << ")\n"
+                          << "  --no-reconnect Exit when the connection fails or closes\n"
+                          << "  --reconnect-min-ms MS  First reconnect delay (default: "
+                          << config.reconnect.initial_delay.count() << ")\n"
+                          << "  --reconnect-max-ms MS  Maximum reconnect delay (default: "
+                          << config.reconnect.max_delay.count() << ")\n"
+                          << "  --reconnect-attempts N Give up after N failed attempts in a row (default: 0, unlimited)\n"
+                          << "  --record FILE  Write the raw received stream to FILE\n"
+                          << "  --replay FILE  Process a recording instead of connecting (as fast as possible)\n"
+                          << "  --replay-paced With --replay, reproduce the recorded timing\n"
+                          << "  --help, -h     Show this help message\n";
+                return 0;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid arguments: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (config.decay_alpha != 0.0 && !(config.decay_alpha > 0.0 && config.decay_alpha < 1.0)) {
+        std::cerr << "Invalid arguments: --decay-alpha must be between 0 and 1" << std::endl;
+        return 1;
+    }
+    if (config.waterfall.frames > 0 && config.waterfall.seconds > 0.0) {
+        std::cerr << "Invalid arguments: --waterfall-frames and --waterfall-seconds cannot be combined" << std::endl;
+        return 1;
+    }
+    if (config.waterfall.enabled()) {
+        // The bin count is only known from the first frame; see add_to_views for that check
+        uint64_t max_bins = config.waterfall.max_bins();
+        if (max_bins == 0) {
+            std::cerr << "Invalid arguments: --waterfall-rows " << config.waterfall.rows << " does not fit in "
+                      << "--waterfall-max-mb " << (config.waterfall.max_bytes >> 20)
+                      << " (rows x bins x 4 bytes)" << std::endl;
+            return 1;
         }
+        std::cout << "Waterfall: " << config.waterfall.rows << " rows of up to " << max_bins
+                  << " bins within " << (config.waterfall.max_bytes >> 20) << " MiB" << std::endl;
     }
+    if (config.window.frames > 0 && config.window.seconds > 0.0) {
+        std::cerr << "Invalid arguments: --window-frames and --window-seconds cannot be combined" << std::endl;
+        return 1;
+    }
+
+    if (config.replay) {
+        if (!config.record_path.empty()) {
+            std::cerr << "Invalid arguments: --record and --replay cannot be combined" << std::endl;
+            return 1;
+        }
+        // Replay the recorded sources so output files match the original run
+        config.sources.clear();
+        for (const auto& label : config.replay->sources()) {
+            config.sources.push_back(SourceEndpoint::parse(label));
+        }
+    } else if (config.sources.empty()) {
+        config.sources.push_back({host, port});
+    }
+
+    // No SA_RESTART, so blocking calls return EINTR and the loops notice the stop
+    struct sigaction action{};
+    action.sa_handler = handle_stop_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
 
     try {
-        TPX3HistogramApp app;
-        return app.run(host, port);
+        TPX3HistogramApp app(config);
+        return app.run();
     } catch (const std::exception& e) {
         std::cerr << "Fatal error: " << e.what() << std::endl;
         return 1;
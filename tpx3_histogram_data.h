@@ -0,0 +1,290 @@
+#ifndef TPX3_HISTOGRAM_DATA_H
+#define TPX3_HISTOGRAM_DATA_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "tpx3_accumulate.h"
+#include "tpx3_chunked_storage.h"
+#include "tpx3_span.h"
+#include "tpx3_worker_pool.h"
+
+constexpr double TPX3_TDC_CLOCK_PERIOD_SEC = (1.5625 / 6.0) * 1e-9;
+
+/**
+ * @brief Affine time-of-flight bin axis: edge(i) = (offset + i * width) * clock period
+ *
+ * Frames of one acquisition share the same axis, so histograms hold it by
+ * shared pointer instead of a binSize + 1 edge vector. Edges are computed on
+ * demand, e.g. while writing output; materialize() builds the vector only for
+ * callers that really need one.
+ */
+class BinAxis {
+public:
+    BinAxis(size_t bin_count, int bin_width, int bin_offset,
+            double clock_period = TPX3_TDC_CLOCK_PERIOD_SEC)
+        : bin_count_(bin_count), bin_width_(bin_width), bin_offset_(bin_offset),
+          clock_period_(clock_period) {}
+
+    size_t bin_count() const { return bin_count_; }
+    int bin_width() const { return bin_width_; }
+    int bin_offset() const { return bin_offset_; }
+    double clock_period() const { return clock_period_; }
+
+    /**
+     * @brief Edge i (0 <= i <= bin_count) in seconds
+     */
+    template <typename EdgeT = double>
+    EdgeT edge(size_t i) const {
+        assert(i <= bin_count_);
+        long long ticks = bin_offset_ + static_cast<long long>(i) * bin_width_;
+        return static_cast<EdgeT>(ticks * clock_period_);
+    }
+
+    /**
+     * @brief All bin_count + 1 edges
+     */
+    template <typename EdgeT = double>
+    std::vector<EdgeT> materialize() const {
+        std::vector<EdgeT> edges(bin_count_ + 1);
+        for (size_t i = 0; i < edges.size(); ++i) {
+            edges[i] = edge<EdgeT>(i);
+        }
+        return edges;
+    }
+
+    /**
+     * @brief true if a frame with these parameters uses this axis
+     */
+    bool matches(size_t bin_count, int bin_width, int bin_offset) const {
+        return bin_count == bin_count_ && bin_width == bin_width_ && bin_offset == bin_offset_;
+    }
+
+    bool operator==(const BinAxis& other) const {
+        return matches(other.bin_count_, other.bin_width_, other.bin_offset_) &&
+               clock_period_ == other.clock_period_;
+    }
+    bool operator!=(const BinAxis& other) const { return !(*this == other); }
+
+private:
+    size_t bin_count_;
+    int bin_width_;
+    int bin_offset_;
+    double clock_period_;
+};
+
+/**
+ * @brief Contiguous bin storage in a std::vector, exposed as a single chunk
+ */
+template <typename T>
+class VectorStorage {
+public:
+    explicit VectorStorage(size_t count) : values_(count, 0) {}
+
+    size_t size() const { return values_.size(); }
+    size_t chunk_count() const { return values_.empty() ? 0 : 1; }
+    size_t chunk_offset(size_t) const { return 0; }
+    Span<T> chunk(size_t) { return {values_.data(), values_.size()}; }
+    Span<const T> chunk(size_t) const { return {values_.data(), values_.size()}; }
+
+    T& operator[](size_t index) {
+        assert(index < values_.size());
+        return values_[index];
+    }
+    const T& operator[](size_t index) const {
+        assert(index < values_.size());
+        return values_[index];
+    }
+
+private:
+    std::vector<T> values_;
+};
+
+/**
+ * @brief Histogram with compile-time count, bin-edge and storage types
+ * @tparam CountT Unsigned integer type of one bin (uint16_t, uint32_t, uint64_t)
+ * @tparam EdgeT Floating-point type of the bin edges, in seconds
+ * @tparam Storage VectorStorage (contiguous) or ChunkedStorage (2 MB huge-page chunks)
+ *
+ * Frame data and running sums are distinct instantiations (FrameHistogram,
+ * RunningSum), so there is no runtime type tag and no per-access type check.
+ * Bulk access goes chunk by chunk through Span views; element accessors only
+ * assert their index, which compiles away with NDEBUG. Bin edges come from a
+ * shared BinAxis and are never stored per histogram. Bulk additions can be
+ * spread over a WorkerPool, one task per storage chunk.
+ */
+template <typename CountT, typename EdgeT = double, typename Storage = VectorStorage<CountT>>
+class HistogramData {
+    static_assert(std::is_integral<CountT>::value && std::is_unsigned<CountT>::value,
+                  "HistogramData counts must be an unsigned integer type");
+    static_assert(std::is_floating_point<EdgeT>::value,
+                  "HistogramData edges must be a floating-point type");
+
+public:
+    using count_type = CountT;
+    using edge_type = EdgeT;
+    using storage_type = Storage;
+
+    explicit HistogramData(std::shared_ptr<const BinAxis> axis)
+        : axis_(std::move(axis)), values_(axis_->bin_count()) {}
+
+    size_t get_bin_size() const { return values_.size(); }
+
+    const BinAxis& axis() const { return *axis_; }
+    const std::shared_ptr<const BinAxis>& shared_axis() const { return axis_; }
+
+    // Bulk access, one contiguous chunk at a time
+    const Storage& storage() const { return values_; }
+    size_t chunk_count() const { return values_.chunk_count(); }
+    size_t chunk_offset(size_t chunk) const { return values_.chunk_offset(chunk); }
+    Span<const CountT> chunk(size_t chunk) const { return values_.chunk(chunk); }
+    Span<CountT> chunk(size_t chunk) { return values_.chunk(chunk); }
+
+    // Element access (index asserted in debug builds only)
+    CountT value(size_t index) const { return values_[index]; }
+    void set_value(size_t index, CountT value) { values_[index] = value; }
+
+    EdgeT edge(size_t index) const {
+        return axis_->edge<EdgeT>(index);
+    }
+
+    /**
+     * @brief Add contiguous counts of a narrower or equal type, saturating at the maximum
+     * @param other One count per bin
+     * @param workers Optional pool to spread the chunks over
+     * @return true if at least one bin was capped
+     */
+    template <typename OtherT>
+    bool add_values(Span<const OtherT> other, WorkerPool* workers = nullptr) {
+        static_assert(sizeof(OtherT) <= sizeof(CountT),
+                      "Cannot add wider counts into a narrower histogram");
+        if (other.size() != values_.size()) {
+            throw std::invalid_argument("Bin sizes must match for addition");
+        }
+        return for_each_chunk(workers, [&](Span<CountT> sum, size_t offset) {
+            return add_saturating(sum.data(), other.data() + offset, sum.size());
+        });
+    }
+
+    /**
+     * @brief Add another histogram of a narrower or equal count type, saturating at the maximum
+     * @param workers Optional pool to spread the chunks over
+     * @return true if at least one bin was capped
+     */
+    template <typename OtherT, typename OtherStorage>
+    bool add_histogram(const HistogramData<OtherT, EdgeT, OtherStorage>& other,
+                       WorkerPool* workers = nullptr) {
+        static_assert(sizeof(OtherT) <= sizeof(CountT),
+                      "Cannot add wider counts into a narrower histogram");
+        if (other.chunk_count() <= 1) {
+            return add_values(other.chunk_count() ? other.chunk(0) : Span<const OtherT>(),
+                              workers);
+        }
+        if (other.get_bin_size() != values_.size()) {
+            throw std::invalid_argument("Bin sizes must match for addition");
+        }
+        return for_each_chunk(workers, [&](Span<CountT> sum, size_t offset) {
+            // Chunks hold a fixed number of bytes, so they do not line up across count types
+            size_t c = 0;
+            while (other.chunk_offset(c) + other.chunk(c).size() <= offset) {
+                ++c;
+            }
+            bool overflow = false;
+            for (size_t done = 0; done < sum.size(); ++c) {
+                Span<const OtherT> part = other.chunk(c);
+                size_t start = offset + done - other.chunk_offset(c);
+                size_t length = std::min(part.size() - start, sum.size() - done);
+                overflow |= add_saturating(sum.data() + done, part.data() + start, length);
+                done += length;
+            }
+            return overflow;
+        });
+    }
+
+    /**
+     * @brief Add big-endian 32-bit counts, as received, in one pass
+     * @param workers Optional pool to spread the chunks over
+     * @return true if at least one bin was capped
+     */
+    bool add_values_be32(const uint32_t* wire, size_t count, WorkerPool* workers = nullptr) {
+        if (count != values_.size()) {
+            throw std::invalid_argument("Bin sizes must match for addition");
+        }
+        return for_each_chunk(workers, [&](Span<CountT> sum, size_t offset) {
+            return add_be32(sum.data(), wire + offset, sum.size());
+        });
+    }
+
+private:
+    /**
+     * @brief Run add(chunk, offset) over every chunk, in parallel when a pool is given
+     * @return OR of the per-chunk overflow flags
+     */
+    template <typename Add>
+    bool for_each_chunk(WorkerPool* workers, const Add& add) {
+        size_t chunks = values_.chunk_count();
+        if (!workers || chunks <= 1) {
+            bool overflow = false;
+            for (size_t c = 0; c < chunks; ++c) {
+                overflow |= add(values_.chunk(c), values_.chunk_offset(c));
+            }
+            return overflow;
+        }
+
+        std::atomic<bool> overflow{false};
+        workers->run(chunks, [&](size_t c) {
+            if (add(values_.chunk(c), values_.chunk_offset(c))) {
+                overflow.store(true, std::memory_order_relaxed);
+            }
+        });
+        return overflow.load(std::memory_order_relaxed);
+    }
+
+    // Branch-free per bin so the loop vectorizes
+    template <typename OtherT>
+    static bool add_saturating(CountT* sum, const OtherT* add, size_t count) {
+        bool overflow = false;
+        for (size_t i = 0; i < count; ++i) {
+            CountT value = static_cast<CountT>(sum[i] + add[i]);
+            bool wrapped = value < sum[i];
+            overflow |= wrapped;
+            sum[i] = wrapped ? std::numeric_limits<CountT>::max() : value;
+        }
+        return overflow;
+    }
+
+    static bool add_be32(CountT* sum, const uint32_t* wire, size_t count) {
+        if constexpr (std::is_same<CountT, uint64_t>::value) {
+            return accumulate_be32(sum, wire, count);
+        } else {
+            // Narrower sums: add in 64 bits and clamp
+            constexpr uint64_t limit = std::numeric_limits<CountT>::max();
+            bool overflow = false;
+            for (size_t i = 0; i < count; ++i) {
+                uint64_t value = uint64_t{sum[i]} + __builtin_bswap32(wire[i]);
+                bool capped = value > limit;
+                overflow |= capped;
+                sum[i] = static_cast<CountT>(capped ? limit : value);
+            }
+            return overflow;
+        }
+    }
+
+    std::shared_ptr<const BinAxis> axis_;
+    Storage values_;
+};
+
+// Individual frame data as sent by the server
+using FrameHistogram = HistogramData<uint32_t>;
+// Accumulated data, in huge-page chunks so 10^7-bin sums need no contiguous block
+using RunningSum = HistogramData<uint64_t, double, ChunkedStorage<uint64_t>>;
+
+#endif // TPX3_HISTOGRAM_DATA_H
@@ -0,0 +1,718 @@
+#ifndef TPX3_INGEST_H
+#define TPX3_INGEST_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+// Network includes
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "tpx3_frame_pool.h"
+#include "tpx3_stream_framer.h"
+#include "tpx3_uring.h"
+
+constexpr int INGEST_POLL_INTERVAL_MS = 200;
+constexpr int INGEST_MAX_EVENTS = 64;
+constexpr int INGEST_READ_BUDGET = 16;  // recv() calls per source per wakeup
+constexpr uint64_t INGEST_URING_EVENT = UINT64_MAX;
+constexpr int INGEST_STABLE_CONNECTION_MS = 5000;  // Uptime that resets the backoff even without a frame
+
+/**
+ * @brief How connected sockets are read
+ */
+enum class IngestBackend {
+    RECV,      // epoll readiness + recv() into the framer
+    IO_URING   // Multishot io_uring recv into provided buffers
+};
+
+inline const char* backend_name(IngestBackend backend) {
+    return backend == IngestBackend::IO_URING ? "io_uring" : "recv";
+}
+
+/**
+ * @brief Parse a backend name as given on the command line
+ * @throws std::invalid_argument for unknown names
+ */
+inline IngestBackend parse_backend(const std::string& name) {
+    if (name == "recv") {
+        return IngestBackend::RECV;
+    }
+    if (name == "io_uring" || name == "uring") {
+        return IngestBackend::IO_URING;
+    }
+    throw std::invalid_argument("Unknown backend '" + name + "' (expected recv or io_uring)");
+}
+
+/**
+ * @brief Reconnect behaviour of the supervised connection loop
+ */
+struct ReconnectPolicy {
+    bool enabled = true;
+    std::chrono::milliseconds initial_delay{500};
+    std::chrono::milliseconds max_delay{30000};
+    double multiplier = 2.0;
+    unsigned max_attempts = 0;  // Consecutive failed attempts before giving up, 0 = unlimited
+};
+
+/**
+ * @brief Exponential backoff between connection attempts
+ */
+class ExponentialBackoff {
+public:
+    explicit ExponentialBackoff(const ReconnectPolicy& policy)
+        : policy_(policy), delay_(policy.initial_delay) {}
+
+    /**
+     * @brief Delay to wait before the next attempt; grows the following one
+     */
+    std::chrono::milliseconds next_delay() {
+        auto current = delay_;
+        auto grown = std::chrono::milliseconds(
+            static_cast<long long>(delay_.count() * policy_.multiplier));
+        delay_ = std::min(std::max(grown, delay_), policy_.max_delay);
+        ++attempts_;
+        return current;
+    }
+
+    /**
+     * @brief Forget previous failures after a connection proved healthy
+     */
+    void reset() {
+        delay_ = policy_.initial_delay;
+        attempts_ = 0;
+    }
+
+    bool exhausted() const {
+        return policy_.max_attempts != 0 && attempts_ >= policy_.max_attempts;
+    }
+
+private:
+    ReconnectPolicy policy_;
+    std::chrono::milliseconds delay_;
+    unsigned attempts_ = 0;
+};
+
+/**
+ * @brief Address of one histogram server
+ */
+struct SourceEndpoint {
+    std::string host;
+    int port = 0;
+
+    std::string label() const { return host + ":" + std::to_string(port); }
+
+    /**
+     * @brief Parse "host:port"
+     * @throws std::invalid_argument if the port is missing or not a number
+     */
+    static SourceEndpoint parse(const std::string& text) {
+        size_t colon = text.rfind(':');
+        if (colon == std::string::npos || colon == 0 || colon + 1 == text.size()) {
+            throw std::invalid_argument("Expected host:port, got '" + text + "'");
+        }
+        return {text.substr(0, colon), std::stoi(text.substr(colon + 1))};
+    }
+};
+
+/**
+ * @brief Non-blocking TCP connection to one histogram server
+ */
+class NetworkClient {
+public:
+    enum class ConnectResult {
+        CONNECTED,     // Connected immediately
+        IN_PROGRESS,   // Wait for writability, then call finish_connect()
+        FAILED
+    };
+
+    NetworkClient() : socket_fd_(-1), connected_(false) {}
+
+    ~NetworkClient() {
+        disconnect();
+    }
+
+    // Disable copy
+    NetworkClient(const NetworkClient&) = delete;
+    NetworkClient& operator=(const NetworkClient&) = delete;
+
+    // Allow move
+    NetworkClient(NetworkClient&& other) noexcept
+        : socket_fd_(other.socket_fd_), connected_(other.connected_) {
+        other.socket_fd_ = -1;
+        other.connected_ = false;
+    }
+
+    NetworkClient& operator=(NetworkClient&& other) noexcept {
+        if (this != &other) {
+            disconnect();
+            socket_fd_ = other.socket_fd_;
+            connected_ = other.connected_;
+            other.socket_fd_ = -1;
+            other.connected_ = false;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Start a non-blocking connection to a server
+     * @param host Server IPv4 address
+     * @param port Server port
+     * @return Whether the connection completed, is pending or failed
+     */
+    ConnectResult start_connect(const std::string& host, int port) {
+        disconnect();
+
+        socket_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (socket_fd_ < 0) {
+            std::cerr << "Socket creation failed: " << strerror(errno) << std::endl;
+            return ConnectResult::FAILED;
+        }
+
+        // Set TCP_NODELAY to disable Nagle's algorithm
+        int flag = 1;
+        if (setsockopt(socket_fd_, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag)) < 0) {
+            std::cerr << "Failed to set TCP_NODELAY: " << strerror(errno) << std::endl;
+        }
+
+        // Set larger socket buffers
+        int rcvbuf = 256 * 1024;  // 256KB receive buffer
+        if (setsockopt(socket_fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) < 0) {
+            std::cerr << "Failed to set receive buffer size: " << strerror(errno) << std::endl;
+        }
+
+        struct sockaddr_in server_addr{};
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = htons(port);
+
+        if (inet_pton(AF_INET, host.c_str(), &server_addr.sin_addr) <= 0) {
+            std::cerr << "Invalid address: " << host << std::endl;
+            disconnect();
+            return ConnectResult::FAILED;
+        }
+
+        std::cout << "Attempting to connect to " << host << ":" << port << "..." << std::endl;
+
+        if (::connect(socket_fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+            if (errno == EINPROGRESS) {
+                return ConnectResult::IN_PROGRESS;
+            }
+            std::cerr << "Connection to " << host << ":" << port << " failed: "
+                      << strerror(errno) << std::endl;
+            disconnect();
+            return ConnectResult::FAILED;
+        }
+
+        connected_ = true;
+        return ConnectResult::CONNECTED;
+    }
+
+    /**
+     * @brief Complete a connection that returned IN_PROGRESS
+     * @return true if connected, false if the attempt failed
+     */
+    bool finish_connect() {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(socket_fd_, SOL_SOCKET, SO_ERROR, &error, &length) < 0) {
+            error = errno;
+        }
+        if (error != 0) {
+            std::cerr << "Connection failed: " << strerror(error) << std::endl;
+            disconnect();
+            return false;
+        }
+        connected_ = true;
+        return true;
+    }
+
+    /**
+     * @brief Disconnect from server
+     */
+    void disconnect() {
+        if (socket_fd_ >= 0) {
+            close(socket_fd_);
+            socket_fd_ = -1;
+        }
+        connected_ = false;
+    }
+
+    /**
+     * @brief Check if connected
+     * @return true if connected
+     */
+    bool is_connected() const { return connected_; }
+
+    /**
+     * @brief Socket descriptor, -1 when closed
+     */
+    int fd() const { return socket_fd_; }
+
+    /**
+     * @brief Receive data from socket
+     * @param buffer Buffer to store received data
+     * @param max_size Maximum size to receive
+     * @return Number of bytes received, -1 on error or when no data is ready
+     *         (errno EAGAIN), 0 on connection closed
+     */
+    ssize_t receive(char* buffer, size_t max_size) {
+        if (!connected_ || socket_fd_ < 0) {
+            return -1;
+        }
+
+        ssize_t bytes_read = recv(socket_fd_, buffer, max_size, 0);
+
+        if (bytes_read == 0) {
+            std::cout << "Connection closed by peer" << std::endl;
+            connected_ = false;
+        } else if (bytes_read < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "Socket error: " << strerror(errno) << std::endl;
+                connected_ = false;
+            }
+        }
+
+        return bytes_read;
+    }
+
+private:
+    int socket_fd_;
+    bool connected_;
+};
+
+/**
+ * @brief Per-source counters reported by IngestLoop
+ */
+struct SourceStats {
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+    uint64_t reconnects = 0;
+    std::chrono::steady_clock::duration downtime{0};
+    uint64_t resyncs = 0;
+    uint64_t skipped_bytes = 0;
+    uint64_t lost_frames = 0;
+    bool gave_up = false;
+};
+
+/**
+ * @brief Single-threaded epoll event loop receiving from any number of servers
+ *
+ * Every source has its own non-blocking NetworkClient, StreamFramer and
+ * reconnect backoff. Connections are established asynchronously, readable
+ * sockets are served round-robin with a bounded number of reads each, and
+ * reconnect delays are folded into the epoll_wait timeout, so one thread
+ * handles dozens of sources. Completed frames are tagged with their source
+ * index and handed to a single sink.
+ *
+ * With the IO_URING backend, connected sockets leave the epoll set and get
+ * a multishot recv posted on a UringReceiver instead; the ring descriptor
+ * itself sits in the epoll set and wakes the loop when completions arrive.
+ * If io_uring cannot be set up the loop falls back to recv().
+ */
+class IngestLoop {
+public:
+    using FrameSink = std::function<void(FrameBuffer*)>;
+    // Observer of raw received bytes; length 0 marks a disconnect
+    using ReceiveTap = std::function<void(size_t source, const char* data, size_t length)>;
+
+    IngestLoop(FramePool& pool, const std::vector<SourceEndpoint>& endpoints,
+               const ReconnectPolicy& policy, size_t ring_size = DEFAULT_RECEIVE_RING_SIZE,
+               IngestBackend backend = IngestBackend::RECV)
+        : policy_(policy) {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "epoll_create1");
+        }
+
+        if (backend == IngestBackend::IO_URING) {
+            std::string error;
+            uring_ = UringReceiver::create(error);
+            if (uring_) {
+                epoll_event event{};
+                event.data.u64 = INGEST_URING_EVENT;
+                event.events = EPOLLIN;
+                if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, uring_->fd(), &event) < 0) {
+                    throw std::system_error(errno, std::generic_category(), "epoll_ctl");
+                }
+            } else {
+                std::cerr << "io_uring unavailable (" << error << "), falling back to recv"
+                          << std::endl;
+            }
+        }
+
+        for (size_t i = 0; i < endpoints.size(); ++i) {
+            sources_.push_back(std::make_unique<Source>(i, endpoints[i], pool, ring_size, policy));
+        }
+    }
+
+    ~IngestLoop() {
+        if (epoll_fd_ >= 0) {
+            close(epoll_fd_);
+        }
+    }
+
+    // Disable copy
+    IngestLoop(const IngestLoop&) = delete;
+    IngestLoop& operator=(const IngestLoop&) = delete;
+
+    /**
+     * @brief Run until every source has finished or stop becomes true
+     * @param stop Checked at least every INGEST_POLL_INTERVAL_MS
+     * @param sink Receives completed frames with FrameBuffer::source set
+     * @return false if any source gave up connecting
+     */
+    bool run(const std::atomic<bool>& stop, const FrameSink& sink) {
+        for (size_t i = 0; i < sources_.size(); ++i) {
+            Source& source = *sources_[i];
+            source.sink = [&sink, i](FrameBuffer* frame) {
+                frame->source = i;
+                sink(frame);
+            };
+        }
+
+        epoll_event events[INGEST_MAX_EVENTS];
+
+        while (!stop) {
+            auto now = std::chrono::steady_clock::now();
+            int timeout_ms = start_due_connections(now);
+            if (timeout_ms < 0) {
+                break;  // All sources finished
+            }
+
+            int count = epoll_wait(epoll_fd_, events, INGEST_MAX_EVENTS, timeout_ms);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "epoll_wait");
+            }
+
+            now = std::chrono::steady_clock::now();
+            for (int e = 0; e < count; ++e) {
+                if (events[e].data.u64 == INGEST_URING_EVENT) {
+                    reap_uring(now);
+                    continue;
+                }
+                Source& source = *sources_[events[e].data.u64];
+                if (source.state == State::CONNECTING) {
+                    complete_connect(source, now);
+                } else if (source.state == State::CONNECTED) {
+                    read_source(source, now);
+                }
+            }
+        }
+
+        bool all_ok = true;
+        for (auto& source : sources_) {
+            if (source->client.is_connected() || source->state == State::CONNECTING) {
+                close_source(*source, std::chrono::steady_clock::now(), false);
+            }
+            all_ok = all_ok && !source->stats.gave_up;
+        }
+        return all_ok;
+    }
+
+    size_t source_count() const { return sources_.size(); }
+
+    /**
+     * @brief Observe every received byte before it is framed (e.g. to record the stream)
+     */
+    void set_receive_tap(ReceiveTap tap) { tap_ = std::move(tap); }
+
+    /**
+     * @brief Backend actually in use (after any fallback)
+     */
+    IngestBackend backend() const {
+        return uring_ ? IngestBackend::IO_URING : IngestBackend::RECV;
+    }
+
+    /**
+     * @brief Receive syscalls issued: recv() calls, or io_uring_enter() calls
+     */
+    uint64_t receive_syscalls() const {
+        return uring_ ? uring_->enter_calls() : recv_calls_;
+    }
+
+    const SourceEndpoint& endpoint(size_t index) const { return sources_[index]->endpoint; }
+
+    /**
+     * @brief Counters of one source, including its framer's
+     */
+    SourceStats stats(size_t index) const {
+        const Source& source = *sources_[index];
+        SourceStats stats = source.stats;
+        stats.frames = source.framer.frames();
+        stats.bytes = source.framer.bytes_received();
+        stats.resyncs = source.framer.resyncs();
+        stats.skipped_bytes = source.framer.skipped_bytes();
+        stats.lost_frames = source.framer.lost_frames();
+        return stats;
+    }
+
+    uint64_t pool_stalls() const {
+        uint64_t total = 0;
+        for (const auto& source : sources_) {
+            total += source->framer.pool_stalls();
+        }
+        return total;
+    }
+
+private:
+    enum class State {
+        WAITING,      // Next connection attempt at next_attempt
+        CONNECTING,   // Non-blocking connect pending
+        CONNECTED,
+        FINISHED      // Closed without reconnect, or gave up
+    };
+
+    struct Source {
+        Source(size_t index, const SourceEndpoint& endpoint, FramePool& pool, size_t ring_size,
+               const ReconnectPolicy& policy)
+            : index(index), endpoint(endpoint), framer(pool, ring_size), backoff(policy) {}
+
+        size_t index;
+        SourceEndpoint endpoint;
+        uint32_t generation = 0;  // Bumped per connection to spot stale io_uring completions
+        NetworkClient client;
+        StreamFramer framer;
+        ExponentialBackoff backoff;
+        StreamFramer::FrameSink sink;
+        State state = State::WAITING;
+        bool ever_connected = false;
+        std::chrono::steady_clock::time_point next_attempt{};
+        std::chrono::steady_clock::time_point connected_at{};
+        std::chrono::steady_clock::time_point disconnected_at{};
+        uint64_t frames_at_connect = 0;
+        SourceStats stats;
+    };
+
+    /**
+     * @brief Begin connecting every source whose retry time has come
+     * @return epoll_wait timeout in ms, or -1 when no source is left
+     */
+    int start_due_connections(std::chrono::steady_clock::time_point now) {
+        auto wake = now + std::chrono::milliseconds(INGEST_POLL_INTERVAL_MS);
+        bool active = false;
+
+        for (auto& entry : sources_) {
+            Source& source = *entry;
+            if (source.state == State::WAITING && source.next_attempt <= now) {
+                begin_connect(source, now);
+            }
+            if (source.state == State::WAITING) {
+                wake = std::min(wake, source.next_attempt);
+            }
+            active = active || source.state != State::FINISHED;
+        }
+
+        if (!active) {
+            return -1;
+        }
+        auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(wake - now);
+        return static_cast<int>(std::max<long long>(delay.count(), 0));
+    }
+
+    void begin_connect(Source& source, std::chrono::steady_clock::time_point now) {
+        auto result = source.client.start_connect(source.endpoint.host, source.endpoint.port);
+        if (result == NetworkClient::ConnectResult::FAILED) {
+            schedule_retry(source, now);
+            return;
+        }
+
+        epoll_event event{};
+        event.data.u64 = source.index;
+        event.events = result == NetworkClient::ConnectResult::CONNECTED ? EPOLLIN : EPOLLOUT;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, source.client.fd(), &event) < 0) {
+            throw std::system_error(errno, std::generic_category(), "epoll_ctl");
+        }
+
+        source.state = State::CONNECTING;
+        if (result == NetworkClient::ConnectResult::CONNECTED) {
+            on_connected(source, now);
+        }
+    }
+
+    void complete_connect(Source& source, std::chrono::steady_clock::time_point now) {
+        if (!source.client.finish_connect()) {
+            // The descriptor is already closed, which also removed it from epoll
+            schedule_retry(source, now);
+            return;
+        }
+
+        epoll_event event{};
+        event.data.u64 = source.index;
+        event.events = EPOLLIN;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, source.client.fd(), &event);
+        on_connected(source, now);
+    }
+
+    static uint64_t uring_user_data(const Source& source) {
+        return (static_cast<uint64_t>(source.generation) << 32) | source.index;
+    }
+
+    void on_connected(Source& source, std::chrono::steady_clock::time_point now) {
+        source.state = State::CONNECTED;
+        source.connected_at = now;
+        source.frames_at_connect = source.framer.frames();
+
+        if (uring_) {
+            // Reads now complete through the ring instead of epoll readiness
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, source.client.fd(), nullptr);
+            ++source.generation;
+            if (!uring_->arm_recv(source.client.fd(), uring_user_data(source))) {
+                std::cerr << "io_uring submit failed for " << source.endpoint.label() << std::endl;
+            }
+        }
+        std::cout << "Connected to " << source.endpoint.label() << std::endl;
+
+        if (source.ever_connected) {
+            ++source.stats.reconnects;
+            source.stats.downtime += now - source.disconnected_at;
+            std::cout << "Reconnected to " << source.endpoint.label() << " ("
+                      << source.stats.reconnects << " reconnects), continuing running sum"
+                      << std::endl;
+        }
+        source.ever_connected = true;
+        std::cout << "Waiting for data from " << source.endpoint.label() << "..." << std::endl;
+    }
+
+    void schedule_retry(Source& source, std::chrono::steady_clock::time_point now) {
+        if (!policy_.enabled || source.backoff.exhausted()) {
+            source.state = State::FINISHED;
+            source.stats.gave_up = true;
+            return;
+        }
+        auto delay = source.backoff.next_delay();
+        std::cout << "Retrying " << source.endpoint.label() << " in " << delay.count()
+                  << " ms" << std::endl;
+        source.next_attempt = now + delay;
+        source.state = State::WAITING;
+    }
+
+    /**
+     * @brief Serve a readable source with a bounded number of reads
+     */
+    void read_source(Source& source, std::chrono::steady_clock::time_point now) {
+        for (int reads = 0; reads < INGEST_READ_BUDGET; ++reads) {
+            auto region = source.framer.write_region();
+            ssize_t bytes_read = source.client.receive(region.first, region.second);
+            ++recv_calls_;
+
+            if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                return;
+            }
+            if (bytes_read <= 0) {
+                close_source(source, now);
+                return;
+            }
+
+            if (tap_) {
+                tap_(source.index, region.first, static_cast<size_t>(bytes_read));
+            }
+            source.framer.commit(bytes_read);
+            source.framer.drain(source.sink);
+        }
+    }
+
+    /**
+     * @brief Feed every io_uring completion to its source's framer
+     *
+     * Receives that ended are re-armed only after reap() has handed the
+     * consumed buffers back to the kernel; re-armed earlier, a receive that
+     * ran out of buffers (-ENOBUFS) would fail again at once.
+     */
+    void reap_uring(std::chrono::steady_clock::time_point now) {
+        rearm_.clear();
+        uring_->reap([&](uint64_t user_data, int result, bool more, const char* data) {
+            Source& source = *sources_[user_data & 0xffffffffu];
+            if (source.state != State::CONNECTED ||
+                (user_data >> 32) != source.generation) {
+                return;  // Completion of a connection that was already closed
+            }
+
+            if (result > 0) {
+                if (tap_) {
+                    tap_(source.index, data, static_cast<size_t>(result));
+                }
+                source.framer.feed(data, static_cast<size_t>(result), source.sink);
+                if (!more) {
+                    rearm_.push_back(user_data);
+                }
+            } else if (result == -ENOBUFS) {
+                rearm_.push_back(user_data);  // All buffers were busy
+            } else if (!more) {
+                if (result == 0) {
+                    std::cout << "Connection closed by peer" << std::endl;
+                } else {
+                    std::cerr << "Socket error: " << strerror(-result) << std::endl;
+                }
+                close_source(source, now);
+            }
+        });
+
+        for (uint64_t user_data : rearm_) {
+            Source& source = *sources_[user_data & 0xffffffffu];
+            if (source.state == State::CONNECTED && (user_data >> 32) == source.generation) {
+                uring_->arm_recv(source.client.fd(), user_data);
+            }
+        }
+    }
+
+    /**
+     * @brief Close a source's connection and, if reconnect is set, schedule the next attempt
+     */
+    void close_source(Source& source, std::chrono::steady_clock::time_point now, bool reconnect = true) {
+        if (tap_ && source.state == State::CONNECTED) {
+            tap_(source.index, nullptr, 0);
+        }
+        if (uring_ && source.state == State::CONNECTED) {
+            uring_->cancel(uring_user_data(source));
+            ++source.generation;
+        }
+        bool healthy = source.state == State::CONNECTED &&
+                       (source.framer.frames() > source.frames_at_connect ||
+                        now - source.connected_at >= std::chrono::milliseconds(INGEST_STABLE_CONNECTION_MS));
+        source.client.disconnect();  // Closing the descriptor removes it from epoll
+        source.disconnected_at = now;
+        if (source.framer.reset()) {
+            std::cerr << "Connection to " << source.endpoint.label()
+                      << " closed with a partial frame buffered" << std::endl;
+        }
+
+        if (!policy_.enabled || !reconnect) {
+            source.state = State::FINISHED;
+            return;
+        }
+        // A server that accepts and drops connections keeps backing off; one
+        // that delivered a frame or stayed up starts over at the initial delay
+        if (healthy) {
+            source.backoff.reset();
+        }
+        schedule_retry(source, now);
+    }
+
+    ReconnectPolicy policy_;
+    int epoll_fd_ = -1;
+    std::unique_ptr<UringReceiver> uring_;
+    std::vector<std::unique_ptr<Source>> sources_;
+    std::vector<uint64_t> rearm_;  // user_data of receives to re-arm after the current reap
+    uint64_t recv_calls_ = 0;
+    ReceiveTap tap_;
+};
+
+#endif // TPX3_INGEST_H
@@ -0,0 +1,407 @@
+/**
+ * @file tpx3_mock_server.cpp
+ * @brief Synthetic TPX3 histogram server for load-testing tpx3_histogram
+ *
+ * Speaks the same protocol as the acquisition server: one JSON header line
+ * (frameNumber, binSize, binWidth, binOffset, dataSize, countSum) followed by
+ * binSize big-endian uint32 bin counts. Payloads are pregenerated so that the
+ * server itself is never the bottleneck when running unthrottled.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Configuration constants
+constexpr int DEFAULT_MOCK_PORT = 8451;
+constexpr int DEFAULT_MOCK_BINS = 1000;
+constexpr int DEFAULT_MOCK_BIN_WIDTH = 384000;
+constexpr size_t MOCK_PAYLOAD_VARIANTS = 64;  // Distinct pregenerated payloads cycled through
+constexpr int MAX_MOCK_BINS = 1 << 24;
+
+namespace {
+
+std::atomic<bool> g_stop_requested{false};
+
+void handle_stop_signal(int) {
+    g_stop_requested = true;
+}
+
+/**
+ * @brief Shape of the generated bin counts
+ */
+enum class CountDistribution {
+    CONSTANT,  // Every bin holds exactly the mean
+    UNIFORM,   // Uniform in [0, 2 * mean]
+    POISSON,   // Independent Poisson(mean) per bin
+    PEAK       // Gaussian time-of-flight peak on a flat background, Poisson sampled
+};
+
+CountDistribution parse_distribution(const std::string& name) {
+    if (name == "constant") return CountDistribution::CONSTANT;
+    if (name == "uniform") return CountDistribution::UNIFORM;
+    if (name == "poisson") return CountDistribution::POISSON;
+    if (name == "peak") return CountDistribution::PEAK;
+    throw std::invalid_argument("unknown distribution '" + name +
+                                "' (expected constant, uniform, poisson or peak)");
+}
+
+/**
+ * @brief Command line configuration of the mock server
+ */
+struct MockConfig {
+    int port = DEFAULT_MOCK_PORT;
+    int bins = DEFAULT_MOCK_BINS;
+    int bin_width = DEFAULT_MOCK_BIN_WIDTH;
+    int bin_offset = 0;
+    double rate = 10.0;      // Frames per second, 0 = unthrottled
+    int burst = 1;           // Frames sent back to back per tick
+    uint64_t frames = 0;     // Frames per client, 0 = until the client disconnects
+    int clients = 1;         // Clients served one after another, 0 = forever
+    CountDistribution distribution = CountDistribution::POISSON;
+    double mean = 5.0;       // Mean count per bin
+    uint32_t seed = 12345;
+    bool quiet = false;
+};
+
+/**
+ * @brief One pregenerated frame payload in network byte order
+ */
+struct Payload {
+    std::vector<uint32_t> big_endian;
+    uint64_t count_sum = 0;
+};
+
+/**
+ * @brief Pregenerate payload variants for the configured distribution
+ */
+std::vector<Payload> generate_payloads(const MockConfig& config) {
+    std::mt19937 rng(config.seed);
+    std::vector<Payload> payloads(MOCK_PAYLOAD_VARIANTS);
+
+    // Peak: 80% of the counts in a Gaussian around 40% of the range
+    std::vector<double> shape(config.bins, config.mean);
+    if (config.distribution == CountDistribution::PEAK) {
+        double center = 0.4 * config.bins;
+        double sigma = std::max(1.0, 0.05 * config.bins);
+        double norm = 0.0;
+        for (int i = 0; i < config.bins; ++i) {
+            double z = (i - center) / sigma;
+            shape[i] = std::exp(-0.5 * z * z);
+            norm += shape[i];
+        }
+        for (int i = 0; i < config.bins; ++i) {
+            shape[i] = config.mean * (0.2 + 0.8 * config.bins * shape[i] / norm);
+        }
+    }
+
+    for (Payload& payload : payloads) {
+        payload.big_endian.resize(config.bins);
+        std::uniform_real_distribution<double> uniform(0.0, 2.0 * config.mean);
+        for (int i = 0; i < config.bins; ++i) {
+            uint32_t count = 0;
+            switch (config.distribution) {
+                case CountDistribution::CONSTANT:
+                    count = static_cast<uint32_t>(std::llround(config.mean));
+                    break;
+                case CountDistribution::UNIFORM:
+                    count = static_cast<uint32_t>(uniform(rng));
+                    break;
+                case CountDistribution::POISSON:
+                case CountDistribution::PEAK:
+                    count = shape[i] > 0.0
+                        ? static_cast<uint32_t>(std::poisson_distribution<uint32_t>(shape[i])(rng))
+                        : 0;
+                    break;
+            }
+            payload.count_sum += count;
+            payload.big_endian[i] = htonl(count);
+        }
+    }
+    return payloads;
+}
+
+/**
+ * @brief Listening socket that serves one client at a time
+ */
+class MockServer {
+public:
+    explicit MockServer(const MockConfig& config)
+        : config_(config), payloads_(generate_payloads(config)) {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_fd_ < 0) {
+            throw std::runtime_error("Failed to create socket: " + std::string(strerror(errno)));
+        }
+        int opt = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(config_.port);
+        if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            listen(listen_fd_, 1) < 0) {
+            close(listen_fd_);
+            throw std::runtime_error("Failed to listen on port " + std::to_string(config_.port) +
+                                     ": " + strerror(errno));
+        }
+    }
+
+    ~MockServer() {
+        close(listen_fd_);
+    }
+
+    // Disable copy
+    MockServer(const MockServer&) = delete;
+    MockServer& operator=(const MockServer&) = delete;
+
+    /**
+     * @brief Accept and serve clients until the configured count or a stop request
+     */
+    void run() {
+        std::cout << "Serving " << config_.bins << " bins per frame on port " << config_.port;
+        if (config_.rate > 0) {
+            std::cout << " at " << config_.rate << " frames/s";
+        } else {
+            std::cout << " unthrottled";
+        }
+        if (config_.burst > 1) {
+            std::cout << " in bursts of " << config_.burst;
+        }
+        std::cout << std::endl;
+
+        for (int served = 0; config_.clients == 0 || served < config_.clients; ++served) {
+            int fd = accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR && !g_stop_requested) {
+                    --served;
+                    continue;
+                }
+                if (g_stop_requested) {
+                    break;
+                }
+                throw std::runtime_error("Failed to accept: " + std::string(strerror(errno)));
+            }
+            int opt = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+            std::cout << "Client connected" << std::endl;
+            serve(fd);
+            close(fd);
+            if (g_stop_requested) {
+                break;
+            }
+        }
+    }
+
+private:
+    /**
+     * @brief Stream frames to one client with the configured pacing
+     */
+    void serve(int fd) {
+        using clock = std::chrono::steady_clock;
+        const auto tick = config_.rate > 0
+            ? std::chrono::duration_cast<clock::duration>(
+                  std::chrono::duration<double>(config_.burst / config_.rate))
+            : clock::duration::zero();
+
+        const auto start = clock::now();
+        auto next_tick = start;
+        auto last_report = start;
+        uint64_t frames = 0;
+        uint64_t bytes = 0;
+        uint64_t report_frames = 0;
+        uint64_t late_ticks = 0;
+        char header[256];
+
+        while (!g_stop_requested && (config_.frames == 0 || frames < config_.frames)) {
+            if (tick != clock::duration::zero()) {
+                auto now = clock::now();
+                if (now < next_tick) {
+                    std::this_thread::sleep_until(next_tick);
+                } else if (now - next_tick > tick) {
+                    ++late_ticks;
+                }
+                next_tick += tick;
+            }
+
+            for (int b = 0; b < config_.burst && (config_.frames == 0 || frames < config_.frames); ++b) {
+                const Payload& payload = payloads_[frames % payloads_.size()];
+                int header_length = std::snprintf(
+                    header, sizeof(header),
+                    "{\"frameNumber\":%llu,\"binSize\":%d,\"binWidth\":%d,\"binOffset\":%d,"
+                    "\"dataSize\":%lld,\"countSum\":%llu}\n",
+                    static_cast<unsigned long long>(frames), config_.bins, config_.bin_width,
+                    config_.bin_offset, static_cast<long long>(config_.bins) * 4,
+                    static_cast<unsigned long long>(payload.count_sum));
+
+                iovec parts[2] = {
+                    {header, static_cast<size_t>(header_length)},
+                    {const_cast<uint32_t*>(payload.big_endian.data()),
+                     payload.big_endian.size() * sizeof(uint32_t)}};
+                if (!send_all(fd, parts)) {
+                    report(frames, bytes, clock::now() - start, late_ticks, "Client disconnected");
+                    return;
+                }
+                ++frames;
+                bytes += parts[0].iov_len + parts[1].iov_len;
+            }
+
+            auto now = clock::now();
+            if (!config_.quiet && now - last_report >= std::chrono::seconds(1)) {
+                double seconds = std::chrono::duration<double>(now - last_report).count();
+                std::cout << "Sent " << frames << " frames, "
+                          << static_cast<uint64_t>((frames - report_frames) / seconds)
+                          << " frames/s" << std::endl;
+                report_frames = frames;
+                last_report = now;
+            }
+        }
+        report(frames, bytes, clock::now() - start, late_ticks,
+               g_stop_requested ? "Stopped" : "All frames sent");
+    }
+
+    /**
+     * @brief Write both parts of a frame, resuming after partial writes
+     * @return false if the client went away or a stop was requested
+     */
+    bool send_all(int fd, iovec* parts) {
+        int index = 0;
+        while (index < 2) {
+            ssize_t sent = writev(fd, parts + index, 2 - index);
+            if (sent < 0) {
+                if (errno == EINTR && !g_stop_requested) {
+                    continue;
+                }
+                return false;
+            }
+            while (index < 2 && static_cast<size_t>(sent) >= parts[index].iov_len) {
+                sent -= parts[index].iov_len;
+                ++index;
+            }
+            if (index < 2) {
+                parts[index].iov_base = static_cast<char*>(parts[index].iov_base) + sent;
+                parts[index].iov_len -= sent;
+            }
+        }
+        return true;
+    }
+
+    void report(uint64_t frames, uint64_t bytes, std::chrono::steady_clock::duration elapsed,
+                uint64_t late_ticks, const char* reason) const {
+        double seconds = std::max(1e-9, std::chrono::duration<double>(elapsed).count());
+        std::cout << reason << ": " << frames << " frames, " << bytes << " bytes in "
+                  << seconds << " s (" << static_cast<uint64_t>(frames / seconds) << " frames/s, "
+                  << bytes / seconds / 1e6 << " MB/s)";
+        if (config_.rate > 0) {
+            std::cout << ", " << late_ticks << " late ticks";
+        }
+        std::cout << std::endl;
+    }
+
+    MockConfig config_;
+    std::vector<Payload> payloads_;
+    int listen_fd_ = -1;
+};
+
+} // namespace
+
+/**
+ * @brief Main function
+ */
+int main(int argc, char* argv[]) {
+    MockConfig config;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--port" && i + 1 < argc) {
+                config.port = std::stoi(argv[++i]);
+            } else if (arg == "--bins" && i + 1 < argc) {
+                config.bins = std::stoi(argv[++i]);
+            } else if (arg == "--bin-width" && i + 1 < argc) {
+                config.bin_width = std::stoi(argv[++i]);
+            } else if (arg == "--bin-offset" && i + 1 < argc) {
+                config.bin_offset = std::stoi(argv[++i]);
+            } else if (arg == "--rate" && i + 1 < argc) {
+                config.rate = std::stod(argv[++i]);
+            } else if (arg == "--burst" && i + 1 < argc) {
+                config.burst = std::stoi(argv[++i]);
+            } else if (arg == "--frames" && i + 1 < argc) {
+                config.frames = std::stoull(argv[++i]);
+            } else if (arg == "--clients" && i + 1 < argc) {
+                config.clients = std::stoi(argv[++i]);
+            } else if (arg == "--distribution" && i + 1 < argc) {
+                config.distribution = parse_distribution(argv[++i]);
+            } else if (arg == "--mean" && i + 1 < argc) {
+                config.mean = std::stod(argv[++i]);
+            } else if (arg == "--seed" && i + 1 < argc) {
+                config.seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--quiet") {
+                config.quiet = true;
+            } else if (arg == "--help" || arg == "-h") {
+                std::cout << "Usage: " << argv[0] << " [--port PORT] [--bins N] [--rate FPS] [--burst N]\n"
+                          << "       [--frames N] [--clients N] [--distribution NAME] [--mean M]\n"
+                          << "       [--bin-width W] [--bin-offset O] [--seed S] [--quiet] [--help]\n"
+                          << "  --port PORT        Listen port (default: " << DEFAULT_MOCK_PORT << ")\n"
+                          << "  --bins N           Bins per frame (default: " << DEFAULT_MOCK_BINS << ")\n"
+                          << "  --rate FPS         Average frames per second, 0 = unthrottled (default: 10)\n"
+                          << "  --burst N          Send N frames back to back per tick at the same average rate (default: 1)\n"
+                          << "  --frames N         Frames per client, 0 = until it disconnects (default: 0)\n"
+                          << "  --clients N        Clients to serve one after another, 0 = forever (default: 1)\n"
+                          << "  --distribution D   Bin counts: constant, uniform, poisson or peak (default: poisson)\n"
+                          << "  --mean M           Mean count per bin (default: 5)\n"
+                          << "  --bin-width W      binWidth field (default: " << DEFAULT_MOCK_BIN_WIDTH << ")\n"
+                          << "  --bin-offset O     binOffset field (default: 0)\n"
+                          << "  --seed S           Random seed (default: 12345)\n"
+                          << "  --quiet            Only print the final summary per client\n"
+                          << "  --help, -h         Show this help message\n";
+                return 0;
+            } else {
+                throw std::invalid_argument("unknown option '" + arg + "'");
+            }
+        }
+        if (config.bins <= 0 || config.bins > MAX_MOCK_BINS) {
+            throw std::invalid_argument("--bins must be in [1, " + std::to_string(MAX_MOCK_BINS) + "]");
+        }
+        if (config.rate < 0 || config.burst < 1 || config.mean < 0 || config.clients < 0) {
+            throw std::invalid_argument("--rate, --mean and --clients must be >= 0 and --burst >= 1");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid arguments: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // No SA_RESTART, so accept()/writev() return EINTR and the server notices the stop
+    struct sigaction action{};
+    action.sa_handler = handle_stop_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    try {
+        MockServer server(config);
+        server.run();
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,228 @@
+#ifndef TPX3_REBIN_H
+#define TPX3_REBIN_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tpx3_histogram_data.h"
+
+/**
+ * @brief What to do when a frame arrives on a different bin grid than the running sum
+ */
+enum class GridChangePolicy {
+    REBIN,    // Map the frame onto the running sum's grid; restart only if they do not overlap
+    RESTART,  // Start a new running sum on the frame's grid
+};
+
+inline GridChangePolicy parse_grid_change_policy(const std::string& name) {
+    if (name == "rebin") {
+        return GridChangePolicy::REBIN;
+    }
+    if (name == "restart") {
+        return GridChangePolicy::RESTART;
+    }
+    throw std::invalid_argument("Unknown grid change policy: " + name + " (expected rebin or restart)");
+}
+
+/**
+ * @brief Overlap weights that map one frame grid onto a master grid
+ *
+ * Built once per distinct (binSize, binWidth, binOffset) of incoming frames.
+ * Both grids are affine in TDC ticks, so overlaps are exact integer lengths.
+ * Each incoming bin lists the master bins it overlaps with 0.32 fixed-point
+ * weights (overlap / binWidth). The weights of a bin that lies fully inside
+ * the master grid sum to exactly 1.0, so rebinned counts are conserved;
+ * parts outside the master grid are dropped and reported.
+ */
+class RebinTable {
+public:
+    static constexpr int WEIGHT_BITS = 32;
+    static constexpr uint64_t WEIGHT_ONE = uint64_t{1} << WEIGHT_BITS;
+
+    struct Entry {
+        uint32_t master_bin;
+        uint64_t weight;  // Fraction of the incoming bin, WEIGHT_ONE = all of it
+    };
+
+    RebinTable(const BinAxis& frame, const BinAxis& master)
+        : frame_count_(frame.bin_count()), frame_width_(frame.bin_width()),
+          frame_offset_(frame.bin_offset()) {
+        if (frame.bin_width() <= 0 || master.bin_width() <= 0) {
+            throw std::invalid_argument("Cannot rebin a grid with non-positive binWidth");
+        }
+
+        const long long mw = master.bin_width();
+        const long long mo = master.bin_offset();
+        const long long master_end = mo + mw * static_cast<long long>(master.bin_count());
+        const long long fw = frame.bin_width();
+
+        first_entry_.reserve(frame_count_ + 1);
+        for (size_t i = 0; i < frame_count_; ++i) {
+            first_entry_.push_back(static_cast<uint32_t>(entries_.size()));
+            long long lo = frame.bin_offset() + fw * static_cast<long long>(i);
+            long long hi = lo + fw;
+            long long clipped_lo = std::max(lo, mo);
+            long long clipped_hi = std::min(hi, master_end);
+            if (clipped_lo >= clipped_hi) {
+                ++dropped_bins_;
+                continue;
+            }
+            bool inside = clipped_lo == lo && clipped_hi == hi;
+            partial_bins_ += inside ? 0 : 1;
+
+            size_t first = static_cast<size_t>((clipped_lo - mo) / mw);
+            size_t last = static_cast<size_t>((clipped_hi - 1 - mo) / mw);
+            uint64_t assigned = 0;
+            for (size_t j = first; j <= last; ++j) {
+                long long edge_lo = mo + mw * static_cast<long long>(j);
+                long long overlap = std::min(clipped_hi, edge_lo + mw) - std::max(clipped_lo, edge_lo);
+                uint64_t weight = (static_cast<unsigned __int128>(overlap) << WEIGHT_BITS) / fw;
+                if (inside && j == last) {
+                    // The last share absorbs the rounding so the bin sums to exactly one
+                    weight = WEIGHT_ONE - assigned;
+                }
+                assigned += weight;
+                entries_.push_back({static_cast<uint32_t>(j), weight});
+            }
+        }
+        first_entry_.push_back(static_cast<uint32_t>(entries_.size()));
+        identity_ = frame == master;
+    }
+
+    bool matches(size_t bin_count, int bin_width, int bin_offset) const {
+        return bin_count == frame_count_ && bin_width == frame_width_ && bin_offset == frame_offset_;
+    }
+
+    size_t frame_bins() const { return frame_count_; }
+    size_t entries() const { return entries_.size(); }
+    // Incoming bins entirely / partly outside the master grid
+    size_t dropped_bins() const { return dropped_bins_; }
+    size_t partial_bins() const { return partial_bins_; }
+    // True if the frame grid and the master grid do not overlap at all
+    bool disjoint() const { return entries_.empty(); }
+    bool identity() const { return identity_; }
+
+    const Entry* begin(size_t frame_bin) const { return entries_.data() + first_entry_[frame_bin]; }
+    const Entry* end(size_t frame_bin) const { return entries_.data() + first_entry_[frame_bin + 1]; }
+
+private:
+    size_t frame_count_;
+    int frame_width_;
+    int frame_offset_;
+    std::vector<uint32_t> first_entry_;  // CSR row starts, frame_count_ + 1 of them
+    std::vector<Entry> entries_;
+    size_t dropped_bins_ = 0;
+    size_t partial_bins_ = 0;
+    bool identity_ = false;
+};
+
+/**
+ * @brief Adds frames from any compatible grid onto a running sum's master grid
+ *
+ * Tables are cached per incoming grid (most recently used first, at most
+ * CACHE_SIZE of them), so alternating between a few grids builds each table
+ * only once. Fractional shares are carried per master bin in a 0.32
+ * fixed-point residue, so repeated rebinning neither loses nor invents
+ * counts: a bin's integer part is released into the sum once it is whole.
+ */
+class Rebinner {
+public:
+    static constexpr size_t CACHE_SIZE = 8;
+
+    explicit Rebinner(std::shared_ptr<const BinAxis> master)
+        : master_(std::move(master)) {}
+
+    const BinAxis& master() const { return *master_; }
+
+    /**
+     * @brief Whether frames with this binWidth can be mapped onto the master grid at all
+     */
+    bool can_rebin(int bin_width) const {
+        return bin_width > 0 && master_->bin_width() > 0;
+    }
+
+    /**
+     * @brief Table for a frame grid, built on first use
+     * @throws std::invalid_argument unless can_rebin(bin_width)
+     */
+    const RebinTable& table(size_t bin_count, int bin_width, int bin_offset) {
+        for (auto it = cache_.begin(); it != cache_.end(); ++it) {
+            if (it->matches(bin_count, bin_width, bin_offset)) {
+                cache_.splice(cache_.begin(), cache_, it);
+                return cache_.front();
+            }
+        }
+        cache_.emplace_front(BinAxis(bin_count, bin_width, bin_offset), *master_);
+        ++tables_built_;
+        if (cache_.size() > CACHE_SIZE) {
+            cache_.pop_back();
+        }
+        return cache_.front();
+    }
+
+    /**
+     * @brief Add one frame through a table
+     * @param count(i) Count of incoming bin i
+     * @return true if at least one master bin was capped
+     */
+    template <typename Storage, typename CountAt>
+    bool add(HistogramData<uint64_t, double, Storage>& sum, const RebinTable& table,
+             const CountAt& count) {
+        if (residue_.empty()) {
+            residue_.assign(master_->bin_count(), 0);
+        }
+        bool overflow = false;
+        for (size_t i = 0; i < table.frame_bins(); ++i) {
+            uint64_t value = count(i);
+            if (value == 0) {
+                continue;
+            }
+            const RebinTable::Entry* entry = table.begin(i);
+            const RebinTable::Entry* last = table.end(i);
+            if (entry == last) {
+                dropped_ += static_cast<unsigned __int128>(value) << RebinTable::WEIGHT_BITS;
+                continue;
+            }
+            unsigned __int128 kept = 0;
+            for (; entry != last; ++entry) {
+                // value < 2^32 and weight <= 2^32, so the 128-bit product is exact
+                unsigned __int128 share = static_cast<unsigned __int128>(value) * entry->weight +
+                                          residue_[entry->master_bin];
+                uint64_t whole = static_cast<uint64_t>(share >> RebinTable::WEIGHT_BITS);
+                residue_[entry->master_bin] = static_cast<uint32_t>(share);
+                kept += static_cast<unsigned __int128>(value) * entry->weight;
+                uint64_t old = sum.value(entry->master_bin);
+                uint64_t added = old + whole;
+                bool wrapped = added < old;
+                overflow |= wrapped;
+                sum.set_value(entry->master_bin, wrapped ? std::numeric_limits<uint64_t>::max() : added);
+            }
+            // Part of a bin that straddles the master grid's ends
+            dropped_ += (static_cast<unsigned __int128>(value) << RebinTable::WEIGHT_BITS) - kept;
+        }
+        ++frames_rebinned_;
+        return overflow;
+    }
+
+    uint64_t frames_rebinned() const { return frames_rebinned_; }
+    uint64_t tables_built() const { return tables_built_; }
+    // Whole counts that fell outside the master grid
+    uint64_t dropped_counts() const { return static_cast<uint64_t>(dropped_ >> RebinTable::WEIGHT_BITS); }
+
+private:
+    std::shared_ptr<const BinAxis> master_;
+    std::list<RebinTable> cache_;
+    std::vector<uint32_t> residue_;
+    uint64_t frames_rebinned_ = 0;
+    uint64_t tables_built_ = 0;
+    unsigned __int128 dropped_ = 0;  // 0.32 fixed point
+};
+
+#endif // TPX3_REBIN_H
@@ -0,0 +1,444 @@
+#ifndef TPX3_RECORDING_H
+#define TPX3_RECORDING_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tpx3_frame_pool.h"
+#include "tpx3_ingest.h"
+#include "tpx3_stream_framer.h"
+
+/*
+ * Recording file layout (host byte order):
+ *
+ *   header: "TPX3RAW1" | u32 version | u32 source_count
+ *           | source_count x (u32 label_length | label bytes)
+ *   chunk:  u64 nanoseconds since start | u32 source | u32 length | length bytes
+ *
+ * Each chunk holds the bytes of one receive call. A chunk with length 0 marks
+ * a disconnect of that source, so replay drops a partial frame exactly where
+ * the live framer did.
+ */
+constexpr char RECORDING_MAGIC[8] = {'T', 'P', 'X', '3', 'R', 'A', 'W', '1'};
+constexpr uint32_t RECORDING_VERSION = 1;
+constexpr size_t RECORDING_CHUNK_HEADER = 16;
+constexpr size_t RECORDING_BUFFER_SIZE = 8 * 1024 * 1024;
+
+/**
+ * @brief Tees received bytes to a file through a background writer thread
+ *
+ * The receive thread appends into one of two large buffers while the writer
+ * thread writes the other one sequentially, so the receive path only copies
+ * memory. If the disk falls behind, append() waits for the writer (counted as
+ * a stall) rather than dropping bytes: a recording must be exact to be useful.
+ */
+class StreamRecorder {
+public:
+    StreamRecorder(const std::string& path, const std::vector<std::string>& source_labels)
+        : path_(path), start_(std::chrono::steady_clock::now()) {
+        fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to open " + path);
+        }
+        for (auto& buffer : buffers_) {
+            buffer.reserve(RECORDING_BUFFER_SIZE);
+        }
+
+        std::vector<char>& active = buffers_[active_];
+        active.insert(active.end(), RECORDING_MAGIC, RECORDING_MAGIC + sizeof(RECORDING_MAGIC));
+        append_value(active, RECORDING_VERSION);
+        append_value(active, static_cast<uint32_t>(source_labels.size()));
+        for (const auto& label : source_labels) {
+            append_value(active, static_cast<uint32_t>(label.size()));
+            active.insert(active.end(), label.begin(), label.end());
+        }
+
+        writer_ = std::thread(&StreamRecorder::writer_loop, this);
+    }
+
+    ~StreamRecorder() {
+        close();
+    }
+
+    // Disable copy
+    StreamRecorder(const StreamRecorder&) = delete;
+    StreamRecorder& operator=(const StreamRecorder&) = delete;
+
+    /**
+     * @brief Record the bytes of one receive call (receive thread only)
+     * @param source Index of the source the bytes came from
+     * @param data Received bytes, or nullptr with length 0 to mark a disconnect
+     * @param length Number of bytes
+     */
+    void append(size_t source, const char* data, size_t length) {
+        uint64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_).count();
+
+        std::vector<char>* active = &buffers_[active_];
+        if (active->size() + RECORDING_CHUNK_HEADER + length > RECORDING_BUFFER_SIZE &&
+            !active->empty()) {
+            hand_off();
+            active = &buffers_[active_];
+        }
+
+        append_value(*active, timestamp);
+        append_value(*active, static_cast<uint32_t>(source));
+        append_value(*active, static_cast<uint32_t>(length));
+        if (length > 0) {
+            active->insert(active->end(), data, data + length);
+        }
+        ++chunks_;
+        bytes_ += length;
+    }
+
+    /**
+     * @brief Flush everything and stop the writer thread
+     */
+    void close() {
+        if (fd_ < 0) {
+            return;
+        }
+        if (!buffers_[active_].empty()) {
+            hand_off();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closing_ = true;
+        }
+        wake_writer_.notify_one();
+        writer_.join();
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    const std::string& path() const { return path_; }
+    uint64_t chunks() const { return chunks_; }
+    uint64_t bytes() const { return bytes_; }
+
+    /**
+     * @brief Times append() had to wait for the writer thread
+     */
+    uint64_t stalls() const { return stalls_; }
+
+    bool failed() const { return failed_.load(std::memory_order_relaxed); }
+
+private:
+    template <typename T>
+    static void append_value(std::vector<char>& buffer, T value) {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    /**
+     * @brief Pass the active buffer to the writer and continue in the other one
+     */
+    void hand_off() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (pending_) {
+            ++stalls_;
+            writer_idle_.wait(lock, [this] { return !pending_; });
+        }
+        pending_ = true;
+        active_ ^= 1;
+        lock.unlock();
+        wake_writer_.notify_one();
+    }
+
+    void writer_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_writer_.wait(lock, [this] { return pending_ || closing_; });
+            if (!pending_) {
+                return;
+            }
+
+            // The writer owns the inactive buffer until pending_ is cleared
+            std::vector<char>& buffer = buffers_[active_ ^ 1];
+            lock.unlock();
+            write_all(buffer.data(), buffer.size());
+            buffer.clear();
+            lock.lock();
+
+            pending_ = false;
+            writer_idle_.notify_one();
+        }
+    }
+
+    void write_all(const char* data, size_t length) {
+        while (length > 0 && !failed()) {
+            ssize_t written = ::write(fd_, data, length);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "Recording to " << path_ << " failed: " << strerror(errno) << std::endl;
+                failed_.store(true, std::memory_order_relaxed);
+                return;
+            }
+            data += written;
+            length -= static_cast<size_t>(written);
+        }
+    }
+
+    std::string path_;
+    std::chrono::steady_clock::time_point start_;
+    int fd_ = -1;
+
+    std::vector<char> buffers_[2];
+    int active_ = 0;               // Buffer the receive thread appends to
+    bool pending_ = false;         // Inactive buffer is waiting to be written
+    bool closing_ = false;
+    std::mutex mutex_;
+    std::condition_variable wake_writer_;
+    std::condition_variable writer_idle_;
+    std::thread writer_;
+    std::atomic<bool> failed_{false};
+
+    uint64_t chunks_ = 0;
+    uint64_t bytes_ = 0;
+    uint64_t stalls_ = 0;
+};
+
+/**
+ * @brief Memory-mapped, sequential reader of a recording file
+ */
+class RecordingReader {
+public:
+    struct Chunk {
+        uint64_t timestamp_ns = 0;
+        uint32_t source = 0;
+        uint32_t length = 0;
+        const char* data = nullptr;
+    };
+
+    explicit RecordingReader(const std::string& path) : path_(path) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to open " + path);
+        }
+        struct stat info{};
+        if (fstat(fd, &info) < 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "Failed to stat " + path);
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        if (size_ > 0) {
+            void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "Failed to map " + path);
+            }
+            data_ = static_cast<const char*>(mapping);
+            madvise(mapping, size_, MADV_SEQUENTIAL);
+        }
+        ::close(fd);
+
+        if (size_ < sizeof(RECORDING_MAGIC) + 8 ||
+            memcmp(data_, RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) != 0) {
+            unmap();
+            throw std::runtime_error(path + " is not a TPX3 stream recording");
+        }
+        offset_ = sizeof(RECORDING_MAGIC);
+        uint32_t version = read_value<uint32_t>();
+        if (version != RECORDING_VERSION) {
+            unmap();
+            throw std::runtime_error(path + ": unsupported recording version " + std::to_string(version));
+        }
+        uint32_t source_count = read_value<uint32_t>();
+        for (uint32_t i = 0; i < source_count; ++i) {
+            uint32_t length = offset_ + 4 <= size_ ? read_value<uint32_t>() : UINT32_MAX;
+            if (length > size_ - offset_) {
+                unmap();
+                throw std::runtime_error(path + ": truncated recording header");
+            }
+            sources_.emplace_back(data_ + offset_, length);
+            offset_ += length;
+        }
+    }
+
+    ~RecordingReader() {
+        unmap();
+    }
+
+    // Disable copy
+    RecordingReader(const RecordingReader&) = delete;
+    RecordingReader& operator=(const RecordingReader&) = delete;
+
+    /**
+     * @brief Labels ("host:port") of the recorded sources
+     */
+    const std::vector<std::string>& sources() const { return sources_; }
+
+    /**
+     * @brief Read the next chunk
+     * @return false at the end of the recording (or at a truncated last chunk)
+     */
+    bool next(Chunk& chunk) {
+        if (size_ - offset_ < RECORDING_CHUNK_HEADER) {
+            truncated_ = offset_ != size_;
+            return false;
+        }
+        size_t start = offset_;
+        chunk.timestamp_ns = read_value<uint64_t>();
+        chunk.source = read_value<uint32_t>();
+        chunk.length = read_value<uint32_t>();
+        if (chunk.length > size_ - offset_ || chunk.source >= sources_.size()) {
+            offset_ = start;
+            truncated_ = true;
+            return false;
+        }
+        chunk.data = data_ + offset_;
+        offset_ += chunk.length;
+        return true;
+    }
+
+    /**
+     * @brief true if next() stopped at an incomplete or invalid chunk
+     */
+    bool truncated() const { return truncated_; }
+
+    const std::string& path() const { return path_; }
+    size_t size() const { return size_; }
+
+private:
+    template <typename T>
+    T read_value() {
+        T value;
+        memcpy(&value, data_ + offset_, sizeof(T));
+        offset_ += sizeof(T);
+        return value;
+    }
+
+    void unmap() {
+        if (data_) {
+            munmap(const_cast<char*>(data_), size_);
+            data_ = nullptr;
+        }
+    }
+
+    std::string path_;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t offset_ = 0;
+    bool truncated_ = false;
+    std::vector<std::string> sources_;
+};
+
+/**
+ * @brief Feeds a recording through per-source StreamFramers like IngestLoop does
+ *
+ * Every chunk goes through StreamFramer::feed(), so framing, resync and the
+ * accumulation path see exactly the bytes the live receive path saw. Chunks
+ * are replayed as fast as the consumer accepts frames, or at the recorded
+ * pacing.
+ */
+class StreamReplayer {
+public:
+    using FrameSink = std::function<void(FrameBuffer*)>;
+
+    StreamReplayer(FramePool& pool, RecordingReader& reader,
+                   size_t ring_size = DEFAULT_RECEIVE_RING_SIZE)
+        : reader_(reader) {
+        for (size_t i = 0; i < reader_.sources().size(); ++i) {
+            framers_.push_back(std::make_unique<StreamFramer>(pool, ring_size));
+        }
+    }
+
+    // Disable copy
+    StreamReplayer(const StreamReplayer&) = delete;
+    StreamReplayer& operator=(const StreamReplayer&) = delete;
+
+    /**
+     * @brief Replay the whole recording unless stop becomes true
+     * @param paced Sleep to reproduce the recorded timing instead of running flat out
+     * @return false if the recording ended in a truncated chunk
+     */
+    bool run(const std::atomic<bool>& stop, bool paced, const FrameSink& sink) {
+        std::vector<FrameSink> sinks;
+        for (size_t i = 0; i < framers_.size(); ++i) {
+            sinks.push_back([&sink, i](FrameBuffer* frame) {
+                frame->source = i;
+                sink(frame);
+            });
+        }
+
+        std::cout << "Replaying " << reader_.path() << " (" << framers_.size() << " sources, "
+                  << (paced ? "recorded pacing" : "maximum speed") << ")" << std::endl;
+
+        auto start = std::chrono::steady_clock::now();
+        RecordingReader::Chunk chunk;
+        while (!stop && reader_.next(chunk)) {
+            if (paced) {
+                std::this_thread::sleep_until(start + std::chrono::nanoseconds(chunk.timestamp_ns));
+            }
+            StreamFramer& framer = *framers_[chunk.source];
+            if (chunk.length == 0) {
+                if (framer.reset()) {
+                    std::cerr << "Recorded disconnect of " << reader_.sources()[chunk.source]
+                              << " with a partial frame buffered" << std::endl;
+                }
+                continue;
+            }
+            framer.feed(chunk.data, chunk.length, sinks[chunk.source]);
+        }
+        elapsed_ = std::chrono::steady_clock::now() - start;
+
+        if (reader_.truncated()) {
+            std::cerr << "Recording " << reader_.path() << " ends in a truncated chunk" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    size_t source_count() const { return framers_.size(); }
+
+    /**
+     * @brief Counters of one source's framer
+     */
+    SourceStats stats(size_t index) const {
+        const StreamFramer& framer = *framers_[index];
+        SourceStats stats;
+        stats.frames = framer.frames();
+        stats.bytes = framer.bytes_received();
+        stats.resyncs = framer.resyncs();
+        stats.skipped_bytes = framer.skipped_bytes();
+        stats.lost_frames = framer.lost_frames();
+        return stats;
+    }
+
+    uint64_t pool_stalls() const {
+        uint64_t total = 0;
+        for (const auto& framer : framers_) {
+            total += framer->pool_stalls();
+        }
+        return total;
+    }
+
+    std::chrono::steady_clock::duration elapsed() const { return elapsed_; }
+
+private:
+    RecordingReader& reader_;
+    std::vector<std::unique_ptr<StreamFramer>> framers_;
+    std::chrono::steady_clock::duration elapsed_{0};
+};
+
+#endif // TPX3_RECORDING_H
@@ -0,0 +1,332 @@
+#ifndef TPX3_SHM_SEGMENT_H
+#define TPX3_SHM_SEGMENT_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tpx3_histogram_data.h"
+
+constexpr char SHM_SEGMENT_MAGIC[8] = {'T', 'P', 'X', '3', 'L', 'I', 'V', 'E'};
+constexpr uint32_t SHM_SEGMENT_VERSION = 1;
+
+/**
+ * @brief Layout of the start of a live histogram segment in POSIX shared memory
+ *
+ * The first cache line is written once when the segment is created (apart
+ * from superseded). The second holds the seqlock sequence and the fields it
+ * protects; the counts follow at header_size, 64-byte aligned. sequence is
+ * odd while the publisher is writing and advances by 2 per snapshot, so a
+ * reader that sees the same even value before and after reading has a
+ * consistent snapshot.
+ */
+struct ShmSegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;                  // Offset of the counts in bytes
+    uint64_t capacity;                     // Bins the segment has room for
+    std::atomic<uint32_t> superseded;      // 1 once a larger segment replaced this one under the same name
+    uint32_t reserved0;
+
+    alignas(64) std::atomic<uint64_t> sequence;
+    uint64_t bin_count;
+    int32_t bin_width;
+    int32_t bin_offset;
+    double clock_period;
+    uint64_t frames;                       // Frames added to the sum
+    int64_t publish_ns;                    // CLOCK_MONOTONIC (steady_clock) time of the publish
+};
+static_assert(sizeof(ShmSegmentHeader) == 128, "Counts must start on their own cache line");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Seqlock needs a lock-free 64-bit counter");
+
+/**
+ * @brief Shared-memory name for a segment, e.g. "tpx3-histogram" -> "/tpx3-histogram"
+ */
+inline std::string shm_object_name(const std::string& name) {
+    return name.empty() || name[0] == '/' ? name : "/" + name;
+}
+
+/**
+ * @brief Publishes a running sum into a named POSIX shared-memory segment
+ *
+ * publish() never waits for readers: it bumps the sequence to odd, copies
+ * the counts, and bumps it to even again. Readers detect a snapshot that
+ * changed under them and retry. The name is claimed on construction and
+ * never taken over from another process. If the bin count outgrows the
+ * segment, the publisher unlinks its own segment and creates a larger one;
+ * the old one is marked superseded so mapped readers reopen by name. The
+ * segment is unlinked when the publisher is destroyed (mapped readers keep
+ * the last snapshot).
+ */
+class ShmPublisher {
+public:
+    /**
+     * @brief Claim the name with an empty segment (nothing published yet)
+     * @throws std::runtime_error if a segment of that name already exists,
+     *         std::system_error if it cannot be created
+     */
+    explicit ShmPublisher(std::string name) : name_(shm_object_name(name)) {
+        if (name_.size() < 2 || name_.find('/', 1) != std::string::npos) {
+            throw std::invalid_argument("Invalid shared-memory name: " + name);
+        }
+        create(0);
+    }
+
+    ~ShmPublisher() {
+        if (header_) {
+            ::munmap(header_, mapped_size_);
+            ::shm_unlink(name_.c_str());
+        }
+    }
+
+    // Disable copy
+    ShmPublisher(const ShmPublisher&) = delete;
+    ShmPublisher& operator=(const ShmPublisher&) = delete;
+
+    const std::string& name() const { return name_; }
+    uint64_t publishes() const { return publishes_; }
+
+    /**
+     * @brief Publish one snapshot
+     * @param fill fill(counts) writes axis.bin_count() counts into the segment
+     * @throws std::system_error or std::runtime_error if a larger segment cannot be created
+     */
+    template <typename Fill>
+    void publish(const BinAxis& axis, uint64_t frames, const Fill& fill) {
+        if (!header_ || header_->capacity < axis.bin_count()) {  // No segment if a resize failed
+            create(axis.bin_count());
+        }
+        uint64_t sequence = header_->sequence.load(std::memory_order_relaxed);
+        header_->sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        header_->bin_count = axis.bin_count();
+        header_->bin_width = axis.bin_width();
+        header_->bin_offset = axis.bin_offset();
+        header_->clock_period = axis.clock_period();
+        header_->frames = frames;
+        fill(counts());
+        header_->publish_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        header_->sequence.store(sequence + 2, std::memory_order_release);
+        ++publishes_;
+    }
+
+private:
+    uint64_t* counts() {
+        return reinterpret_cast<uint64_t*>(reinterpret_cast<char*>(header_) + sizeof(ShmSegmentHeader));
+    }
+
+    /**
+     * @brief Create the segment, or replace our own by one with room for at least bins bins
+     */
+    void create(size_t bins) {
+        size_t capacity = header_ ? std::max<size_t>(bins, header_->capacity * 2) : bins;
+        if (header_) {
+            // Start from a fresh object so no reader ever maps one that is being resized
+            header_->superseded.store(1, std::memory_order_release);
+            ::munmap(header_, mapped_size_);
+            header_ = nullptr;
+            ::shm_unlink(name_.c_str());
+        }
+        int fd = ::shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd < 0 && errno == EEXIST) {
+            throw std::runtime_error("Shared memory " + name_ + " already exists; another tpx3_histogram may "
+                                     "be publishing under that name (if not, remove /dev/shm" + name_ + ")");
+        }
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "shm_open " + name_);
+        }
+        size_t size = sizeof(ShmSegmentHeader) + capacity * sizeof(uint64_t);
+        void* memory = MAP_FAILED;
+        if (::ftruncate(fd, static_cast<off_t>(size)) == 0) {
+            memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        int error = errno;
+        ::close(fd);
+        if (memory == MAP_FAILED) {
+            ::shm_unlink(name_.c_str());
+            throw std::system_error(error, std::generic_category(), "Mapping shared memory " + name_);
+        }
+
+        // The object is zero-filled: sequence 0 reads as "nothing published yet"
+        header_ = static_cast<ShmSegmentHeader*>(memory);
+        mapped_size_ = size;
+        header_->version = SHM_SEGMENT_VERSION;
+        header_->header_size = sizeof(ShmSegmentHeader);
+        header_->capacity = capacity;
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(header_->magic, SHM_SEGMENT_MAGIC, sizeof(header_->magic));
+    }
+
+    std::string name_;
+    ShmSegmentHeader* header_ = nullptr;
+    size_t mapped_size_ = 0;
+    uint64_t publishes_ = 0;
+};
+
+/**
+ * @brief Reads consistent snapshots from a segment written by ShmPublisher
+ *
+ * Reading takes no locks and makes no syscalls (except to reopen a
+ * superseded segment): the fields and counts are read straight from the
+ * mapping, and the read is retried if the sequence changed meanwhile.
+ */
+class ShmReader {
+public:
+    /**
+     * @brief Fields of one snapshot
+     */
+    struct Snapshot {
+        uint64_t sequence = 0;
+        uint64_t frames = 0;
+        int64_t publish_ns = 0;
+        BinAxis axis{0, 1, 0};
+        uint64_t retries = 0;   // Reads discarded because the publisher was writing
+    };
+
+    /**
+     * @throws std::system_error if the segment does not exist, std::runtime_error if it is not one
+     */
+    explicit ShmReader(std::string name) : name_(shm_object_name(name)) {
+        open();
+    }
+
+    ~ShmReader() {
+        close();
+    }
+
+    // Disable copy
+    ShmReader(const ShmReader&) = delete;
+    ShmReader& operator=(const ShmReader&) = delete;
+
+    /**
+     * @brief Sequence of the latest complete snapshot (0 if none yet); cheap enough to poll
+     */
+    uint64_t sequence() const {
+        return header_->sequence.load(std::memory_order_acquire) & ~uint64_t{1};
+    }
+
+    /**
+     * @brief Visit the current snapshot in place, retrying until it was not torn
+     * @param visit visit(snapshot, counts) may run several times; only the last run is consistent
+     * @param max_retries Give up after this many torn reads
+     * @return false if nothing was published yet or every attempt was torn
+     */
+    template <typename Visit>
+    bool read_with(const Visit& visit, uint64_t max_retries = 1000000) {
+        Snapshot snapshot;
+        while (true) {
+            if (header_->superseded.load(std::memory_order_acquire)) {
+                reopen();
+            }
+            uint64_t before = header_->sequence.load(std::memory_order_acquire);
+            if (before == 0) {
+                return false;
+            }
+            // A torn bin count must not send visit() past the mapping; the sequence check discards it
+            uint64_t bin_count = header_->bin_count;
+            if ((before & 1) == 0 && bin_count <= header_->capacity) {
+                snapshot.sequence = before;
+                snapshot.frames = header_->frames;
+                snapshot.publish_ns = header_->publish_ns;
+                snapshot.axis = BinAxis(bin_count, header_->bin_width, header_->bin_offset,
+                                        header_->clock_period);
+                visit(static_cast<const Snapshot&>(snapshot), counts());
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (header_->sequence.load(std::memory_order_relaxed) == before) {
+                    return true;
+                }
+            }
+            if (++snapshot.retries > max_retries) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * @brief Copy the current snapshot into counts
+     */
+    bool read(Snapshot& snapshot, std::vector<uint64_t>& counts, uint64_t max_retries = 1000000) {
+        return read_with([&](const Snapshot& current, const uint64_t* values) {
+            snapshot = current;
+            counts.assign(values, values + current.axis.bin_count());
+        }, max_retries);
+    }
+
+private:
+    const uint64_t* counts() const {
+        return reinterpret_cast<const uint64_t*>(reinterpret_cast<const char*>(header_) + header_->header_size);
+    }
+
+    void open() {
+        int fd = ::shm_open(name_.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "shm_open " + name_);
+        }
+        struct stat info {};
+        void* memory = MAP_FAILED;
+        if (::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(ShmSegmentHeader)) {
+            memory = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (memory == MAP_FAILED) {
+            throw std::runtime_error("Cannot map shared memory " + name_);
+        }
+        header_ = static_cast<const ShmSegmentHeader*>(memory);
+        mapped_size_ = static_cast<size_t>(info.st_size);
+        if (std::memcmp(header_->magic, SHM_SEGMENT_MAGIC, sizeof(header_->magic)) != 0 ||
+            header_->version != SHM_SEGMENT_VERSION ||
+            header_->header_size + header_->capacity * sizeof(uint64_t) > mapped_size_) {
+            close();
+            throw std::runtime_error(name_ + " is not a live histogram segment");
+        }
+    }
+
+    void close() {
+        if (header_) {
+            ::munmap(const_cast<ShmSegmentHeader*>(header_), mapped_size_);
+            header_ = nullptr;
+        }
+    }
+
+    /**
+     * @brief Switch to the segment that replaced this one, waiting briefly while it is created
+     */
+    void reopen() {
+        close();
+        for (int attempt = 0;; ++attempt) {
+            try {
+                open();
+                return;
+            } catch (const std::exception&) {
+                if (attempt == 1000) {
+                    throw;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    std::string name_;
+    const ShmSegmentHeader* header_ = nullptr;
+    size_t mapped_size_ = 0;
+};
+
+#endif // TPX3_SHM_SEGMENT_H
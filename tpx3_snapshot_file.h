@@ -0,0 +1,188 @@
+#ifndef TPX3_SNAPSHOT_FILE_H
+#define TPX3_SNAPSHOT_FILE_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "tpx3_histogram_data.h"
+#include "tpx3_span.h"
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "Binary snapshots are written straight from memory and must be little-endian");
+
+/**
+ * @brief Write parts one after the other to path via <path>.tmp and a rename
+ *
+ * Readers see either the previous or the new complete file, never a partial
+ * one, and can reload on the rename (inotify IN_MOVED_TO) instead of polling.
+ * @return true on success; failures are reported on std::cerr
+ */
+inline bool write_file_atomically(const std::string& path, std::initializer_list<Span<const char>> parts) {
+    std::string temp = path + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to open file: " << temp << std::endl;
+        return false;
+    }
+    bool ok = true;
+    for (const Span<const char>& part : parts) {
+        size_t written = 0;
+        while (ok && written < part.size()) {
+            ssize_t n = ::write(fd, part.data() + written, part.size() - written);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            ok = n > 0;
+            written += ok ? static_cast<size_t>(n) : 0;
+        }
+    }
+    if (::close(fd) != 0 || !ok) {
+        std::cerr << "Failed to write file: " << temp << std::endl;
+        std::remove(temp.c_str());
+        return false;
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to rename " << temp << " to " << path << ": " << std::strerror(errno) << std::endl;
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+Span<const char> as_bytes(const T* data, size_t count) {
+    return {reinterpret_cast<const char*>(data), count * sizeof(T)};
+}
+
+/**
+ * @brief Files the running sum is written as
+ */
+struct OutputFormats {
+    bool text = true;     // <output>.txt, tab-separated edges and counts
+    bool binary = false;  // <output>.tpx3h, BinarySnapshotHeader + uint64 counts
+    bool npy = false;     // <output>.npy, uint64 counts as a NumPy array
+};
+
+/**
+ * @brief Parse a comma-separated list such as "text,npy"
+ */
+inline OutputFormats parse_output_formats(const std::string& list) {
+    OutputFormats formats;
+    formats.text = false;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        std::string name = list.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        if (name == "text") {
+            formats.text = true;
+        } else if (name == "binary") {
+            formats.binary = true;
+        } else if (name == "npy") {
+            formats.npy = true;
+        } else {
+            throw std::invalid_argument("Unknown output format: " + name + " (expected text, binary or npy)");
+        }
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    return formats;
+}
+
+constexpr char BINARY_SNAPSHOT_MAGIC[8] = {'T', 'P', 'X', '3', 'H', 'I', 'S', 'T'};
+constexpr uint32_t BINARY_SNAPSHOT_VERSION = 1;
+
+/**
+ * @brief Fixed 64-byte header of a binary running-sum snapshot (.tpx3h)
+ *
+ * The header is followed directly by bin_count little-endian uint64 counts,
+ * which therefore start 64-byte aligned in the file and in any mmap of it.
+ * Bin i spans [bin_offset + i * bin_width, bin_offset + (i + 1) * bin_width)
+ * TDC ticks of clock_period seconds.
+ */
+struct BinarySnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;   // Offset of the counts in bytes
+    uint64_t bin_count;
+    int32_t bin_width;
+    int32_t bin_offset;
+    double clock_period;
+    uint64_t frames;        // Frames added to the sum
+    uint64_t generation;    // Checkpoint number, increases with every write
+    uint64_t reserved;
+
+    static BinarySnapshotHeader make(const BinAxis& axis, uint64_t frames, uint64_t generation) {
+        BinarySnapshotHeader header{};
+        std::memcpy(header.magic, BINARY_SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = BINARY_SNAPSHOT_VERSION;
+        header.header_size = sizeof(BinarySnapshotHeader);
+        header.bin_count = axis.bin_count();
+        header.bin_width = axis.bin_width();
+        header.bin_offset = axis.bin_offset();
+        header.clock_period = axis.clock_period();
+        header.frames = frames;
+        header.generation = generation;
+        return header;
+    }
+
+    /**
+     * @brief Validate a header at the start of a file of size bytes
+     * @throws std::runtime_error if it is not a complete version 1 snapshot
+     */
+    static const BinarySnapshotHeader& from_bytes(const void* data, size_t size) {
+        if (size < sizeof(BinarySnapshotHeader)) {
+            throw std::runtime_error("File too short for a snapshot header");
+        }
+        const auto& header = *static_cast<const BinarySnapshotHeader*>(data);
+        if (std::memcmp(header.magic, BINARY_SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+            throw std::runtime_error("Not a binary histogram snapshot (bad magic)");
+        }
+        if (header.version != BINARY_SNAPSHOT_VERSION || header.header_size < sizeof(BinarySnapshotHeader)) {
+            throw std::runtime_error("Unsupported snapshot version " + std::to_string(header.version));
+        }
+        if (size < header.header_size || (size - header.header_size) / sizeof(uint64_t) < header.bin_count) {
+            throw std::runtime_error("Snapshot truncated: " + std::to_string(header.bin_count) + " bins expected");
+        }
+        return header;
+    }
+
+    const uint64_t* counts() const {
+        return reinterpret_cast<const uint64_t*>(reinterpret_cast<const char*>(this) + header_size);
+    }
+};
+static_assert(sizeof(BinarySnapshotHeader) == 64, "Snapshot header must stay 64 bytes");
+
+/**
+ * @brief NumPy .npy (format 1.0) header for a 1-D array of count elements
+ * @param descr NumPy type string, e.g. "<u8" or "<f8"
+ *
+ * Padded to a multiple of 64 bytes, so the data that follows is aligned and
+ * np.load(..., mmap_mode="r") can map it directly.
+ */
+inline std::string npy_header(size_t count, const char* descr) {
+    std::string dict = std::string("{'descr': '") + descr + "', 'fortran_order': False, 'shape': (" +
+                       std::to_string(count) + ",), }";
+    std::string header("\x93NUMPY\x01\x00", 8);
+    size_t length = dict.size() + 1;  // Including the terminating newline
+    length += (64 - (10 + length) % 64) % 64;
+    header += static_cast<char>(length & 0xff);
+    header += static_cast<char>(length >> 8);
+    header += dict;
+    header.append(length - dict.size() - 1, ' ');
+    header += '\n';
+    return header;
+}
+
+#endif // TPX3_SNAPSHOT_FILE_H
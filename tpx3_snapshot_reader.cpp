@@ -0,0 +1,210 @@
+/**
+ * @file tpx3_snapshot_reader.cpp
+ * @brief Inspect a running sum published by tpx3_histogram, as a .tpx3h file or in shared memory
+ *
+ * Maps the file (or the --shm segment) and reads the counts in place,
+ * without parsing. Prints the header and a summary of the counts, or with
+ * --text the same tab-separated text tpx3_histogram writes, for tools that
+ * only read the text format. Also the reference reader for the shared-memory
+ * seqlock protocol: --follow prints a line for every new snapshot.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tpx3_shm_segment.h"
+#include "tpx3_snapshot_file.h"
+#include "tpx3_text_format.h"
+
+namespace {
+
+/**
+ * @brief Read-only mapping of a whole file
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat " + path + ": " + std::strerror(errno));
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        if (size_ > 0) {
+            data_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);  // The mapping keeps the file contents alive, even after a rename over it
+        if (data_ == MAP_FAILED) {
+            throw std::runtime_error("Cannot map " + path + ": " + std::strerror(errno));
+        }
+    }
+
+    ~MappedFile() {
+        if (data_ && data_ != MAP_FAILED) {
+            ::munmap(data_, size_);
+        }
+    }
+
+    // Disable copy
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const void* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+struct CountSummary {
+    long double total = 0;
+    uint64_t peak = 0;
+    size_t peak_bin = 0;
+};
+
+CountSummary summarize(const uint64_t* counts, size_t bins) {
+    unsigned __int128 total = 0;
+    CountSummary summary;
+    for (size_t i = 0; i < bins; ++i) {
+        total += counts[i];
+        if (counts[i] > summary.peak) {
+            summary.peak = counts[i];
+            summary.peak_bin = i;
+        }
+    }
+    summary.total = static_cast<long double>(total);
+    return summary;
+}
+
+void print_summary(const BinAxis& axis, uint64_t frames, uint64_t generation, const uint64_t* counts) {
+    CountSummary summary = summarize(counts, axis.bin_count());
+    std::cout << "Bins:        " << axis.bin_count() << " (binWidth " << axis.bin_width()
+              << ", binOffset " << axis.bin_offset() << " ticks of " << axis.clock_period() << " s)\n"
+              << "Range:       " << axis.edge(0) << " s to " << axis.edge(axis.bin_count()) << " s\n"
+              << "Frames:      " << frames << "\n"
+              << "Generation:  " << generation << "\n"
+              << "Total count: " << summary.total << "\n";
+    if (axis.bin_count() > 0) {
+        std::cout << "Peak:        " << summary.peak << " in bin " << summary.peak_bin << " ("
+                  << axis.edge(summary.peak_bin) << " s)\n";
+    }
+}
+
+void print_text(const BinAxis& axis, const uint64_t* counts) {
+    std::vector<char> buffer;
+    size_t length = text_format::format_histogram(buffer, axis, [counts](size_t i) { return counts[i]; });
+    std::fwrite(buffer.data(), 1, length, stdout);
+}
+
+int64_t steady_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Read one snapshot from shared memory, or print one line per snapshot until interrupted
+ */
+int read_shm(const std::string& name, bool text, bool follow) {
+    ShmReader reader(name);
+    ShmReader::Snapshot snapshot;
+    std::vector<uint64_t> counts;
+    if (!follow) {
+        if (!reader.read(snapshot, counts)) {
+            std::cerr << "Nothing published in " << name << " yet" << std::endl;
+            return 1;
+        }
+        if (text) {
+            print_text(snapshot.axis, counts.data());
+        } else {
+            print_summary(snapshot.axis, snapshot.frames, snapshot.sequence / 2, counts.data());
+        }
+        return 0;
+    }
+
+    // Polling the sequence is a plain load; only a new snapshot is copied
+    uint64_t seen = 0;
+    while (true) {
+        if (reader.sequence() == seen) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        if (!reader.read(snapshot, counts)) {
+            continue;
+        }
+        seen = snapshot.sequence;
+        CountSummary summary = summarize(counts.data(), counts.size());
+        std::cout << "generation " << snapshot.sequence / 2 << ": " << snapshot.frames << " frames, "
+                  << counts.size() << " bins, total " << summary.total << ", "
+                  << (steady_now_ns() - snapshot.publish_ns) / 1000 << " us after publish, "
+                  << snapshot.retries << " retries" << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    std::string shm_name;
+    bool text = false;
+    bool follow = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--text") {
+            text = true;
+        } else if (arg == "--shm" && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else if (arg == "--follow") {
+            follow = true;
+        } else if (arg == "--help" || arg == "-h" || !path.empty()) {
+            std::cout << "Usage: " << argv[0] << " FILE.tpx3h [--text]\n"
+                      << "       " << argv[0] << " --shm NAME [--text | --follow]\n"
+                      << "  Print the header and a summary of a binary running-sum snapshot\n"
+                      << "  --shm NAME  Read the shared-memory segment of tpx3_histogram --shm NAME instead\n"
+                      << "  --text      Print the histogram in tpx3_histogram's text format instead\n"
+                      << "  --follow    With --shm, print a line for every new snapshot until interrupted\n";
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        } else {
+            path = arg;
+        }
+    }
+    if (path.empty() == shm_name.empty()) {
+        std::cerr << "Usage: " << argv[0] << " FILE.tpx3h [--text] | --shm NAME [--text | --follow]" << std::endl;
+        return 1;
+    }
+
+    try {
+        if (!shm_name.empty()) {
+            return read_shm(shm_name, text, follow);
+        }
+        MappedFile file(path);
+        const BinarySnapshotHeader& header = BinarySnapshotHeader::from_bytes(file.data(), file.size());
+        BinAxis axis(header.bin_count, header.bin_width, header.bin_offset, header.clock_period);
+        if (text) {
+            print_text(axis, header.counts());
+        } else {
+            std::cout << "Version:     " << header.version << "\n";
+            print_summary(axis, header.frames, header.generation, header.counts());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef TPX3_SPAN_H
+#define TPX3_SPAN_H
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+/**
+ * @brief Minimal non-owning view of a contiguous array (std::span stand-in for C++17)
+ */
+template <typename T>
+class Span {
+public:
+    Span() = default;
+    Span(T* data, size_t size) : data_(data), size_(size) {}
+
+    // Allow Span<const T> from Span<T>
+    template <typename U, typename = std::enable_if_t<std::is_convertible<U (*)[], T (*)[]>::value>>
+    Span(const Span<U>& other) : data_(other.data()), size_(other.size()) {}
+
+    T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+
+    T& operator[](size_t index) const {
+        assert(index < size_);
+        return data_[index];
+    }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+#endif // TPX3_SPAN_H
@@ -0,0 +1,139 @@
+#ifndef TPX3_SPSC_RING_H
+#define TPX3_SPSC_RING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Bounded lock-free single-producer/single-consumer ring
+ *
+ * Exactly one thread may call try_push() and exactly one other thread may
+ * call try_pop(). Capacity is rounded up to a power of two. The producer and
+ * consumer indices live on separate cache lines, and each side keeps a cached
+ * copy of the other side's index so the shared line is only touched when the
+ * ring looks full (producer) or empty (consumer).
+ */
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : mask_(round_up_pow2(capacity < 2 ? 2 : capacity) - 1),
+          slots_(mask_ + 1) {}
+
+    // Disable copy and move (indices are shared between threads)
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /**
+     * @brief Push an item (producer thread only)
+     * @param item Item to move into the ring
+     * @return true if pushed, false if the ring is full
+     */
+    bool try_push(T&& item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - producer_cached_head_ > mask_) {
+            producer_cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - producer_cached_head_ > mask_) {
+                return false;
+            }
+        }
+
+        slots_[tail & mask_] = std::move(item);
+        tail_.store(tail + 1, std::memory_order_release);
+
+        // Only the producer writes the high-water mark
+        size_t depth = tail + 1 - producer_cached_head_;
+        if (depth > high_water_.load(std::memory_order_relaxed)) {
+            high_water_.store(depth, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Pop an item (consumer thread only)
+     * @param item Receives the popped item
+     * @return true if an item was popped, false if the ring is empty
+     */
+    bool try_pop(T& item) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == consumer_cached_tail_) {
+            consumer_cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == consumer_cached_tail_) {
+                return false;
+            }
+        }
+
+        item = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Current number of queued items (approximate when read concurrently)
+     */
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return tail >= head ? tail - head : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    /**
+     * @brief Largest depth observed by the producer since construction
+     */
+    size_t high_water_mark() const {
+        return high_water_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static size_t round_up_pow2(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const size_t mask_;
+    std::vector<T> slots_;
+
+    // Consumer side
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t consumer_cached_tail_ = 0;
+
+    // Producer side
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t producer_cached_head_ = 0;
+    std::atomic<size_t> high_water_{0};
+};
+
+/**
+ * @brief Spin-then-sleep backoff for threads polling an SpscRing
+ */
+class SpinBackoff {
+public:
+    void pause() {
+        if (spins_ < 64) {
+            ++spins_;
+        } else if (spins_ < 128) {
+            ++spins_;
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    void reset() { spins_ = 0; }
+
+private:
+    unsigned spins_ = 0;
+};
+
+#endif // TPX3_SPSC_RING_H
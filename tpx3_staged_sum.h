@@ -0,0 +1,223 @@
+#ifndef TPX3_STAGED_SUM_H
+#define TPX3_STAGED_SUM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "tpx3_accumulate.h"
+#include "tpx3_chunked_storage.h"
+#include "tpx3_histogram_data.h"
+#include "tpx3_worker_pool.h"
+
+/**
+ * @brief 64-bit running sum fed through 32-bit staging bins
+ *
+ * Frames are added into 32-bit staging sums, which halves the bytes read and
+ * written per bin compared with widening every frame into 64 bits. The
+ * staging bins are flushed into the 64-bit RunningSum when the headroom runs
+ * out (the largest staged value plus the largest count seen in any frame
+ * would no longer fit in 32 bits) or when a snapshot is requested. An
+ * outlier frame that beats the estimate cannot overflow: a wrapping bin
+ * carries 2^32 straight into its 64-bit sum. Once frames carry counts so
+ * high that fewer than MIN_FRAMES_PER_FLUSH of them fit between flushes,
+ * staging no longer pays off and frames go straight into the 64-bit sum.
+ *
+ * The total of a bin is sum().value(i) + its staged count. Other paths (the
+ * rebinner, host-order frames) may add into sum() directly without a flush.
+ */
+class StagedSum {
+public:
+    using Staging = ChunkedStorage<uint32_t>;
+    static constexpr uint32_t MIN_FRAMES_PER_FLUSH = 16;
+    static_assert(Staging::CHUNK_ELEMENTS % RunningSum::storage_type::CHUNK_ELEMENTS == 0,
+                  "Each running-sum chunk must lie within one staging chunk");
+
+    explicit StagedSum(std::shared_ptr<const BinAxis> axis)
+        : sum_(axis), staging_(axis->bin_count()), chunk_stats_(sum_.chunk_count()) {}
+
+    const BinAxis& axis() const { return sum_.axis(); }
+    const std::shared_ptr<const BinAxis>& shared_axis() const { return sum_.shared_axis(); }
+    size_t get_bin_size() const { return sum_.get_bin_size(); }
+
+    /**
+     * @brief The 64-bit part, without the staged counts
+     */
+    RunningSum& sum() { return sum_; }
+    const RunningSum& sum() const { return sum_; }
+
+    // Chunks of the 64-bit part and the staged counts of the same bins
+    size_t chunk_count() const { return sum_.chunk_count(); }
+    size_t chunk_offset(size_t chunk) const { return sum_.chunk_offset(chunk); }
+    Span<const uint64_t> flushed(size_t chunk) const { return sum_.chunk(chunk); }
+    Span<const uint32_t> staged(size_t chunk) const {
+        return {staging_for(chunk), sum_.chunk(chunk).size()};
+    }
+
+    /**
+     * @brief Total count of one bin, saturated at UINT64_MAX
+     */
+    uint64_t value(size_t index) const {
+        return saturating_add(sum_.value(index), staging_[index]);
+    }
+
+    /**
+     * @brief Write the total count of every bin to out, chunk by chunk, without flushing
+     */
+    void copy_values(uint64_t* out) const {
+        for (size_t c = 0; c < chunk_count(); ++c) {
+            Span<const uint64_t> sum = flushed(c);
+            uint64_t* dest = out + chunk_offset(c);
+            if (staged_frames_ == 0) {
+                // Nothing staged since the last flush (or staging is bypassed)
+                std::memcpy(dest, sum.data(), sum.size() * sizeof(uint64_t));
+                continue;
+            }
+            const uint32_t* staging = staging_for(c);
+            for (size_t i = 0; i < sum.size(); ++i) {
+                dest[i] = saturating_add(sum[i], staging[i]);
+            }
+        }
+    }
+
+    /**
+     * @brief Add big-endian 32-bit counts, as received
+     * @param workers Optional pool to spread the chunks over
+     * @return true if at least one bin was capped at UINT64_MAX
+     */
+    bool add_be32(const uint32_t* wire, size_t count, WorkerPool* workers = nullptr) {
+        if (count != sum_.get_bin_size()) {
+            throw std::invalid_argument("Bin sizes must match for addition");
+        }
+        if (!staging_enabled()) {
+            ++direct_frames_;
+            return sum_.add_values_be32(wire, count, workers);
+        }
+        size_t chunks = sum_.chunk_count();
+        for (auto& stats : chunk_stats_) {
+            stats = accumulate::StageStats{};
+        }
+        auto stage_chunk = [&](size_t c) {
+            Span<uint64_t> sum = sum_.chunk(c);
+            stage_be32(staging_for(c), sum.data(), wire + sum_.chunk_offset(c), sum.size(),
+                       chunk_stats_[c]);
+        };
+        if (workers) {
+            workers->run(chunks, stage_chunk);
+        } else {
+            for (size_t c = 0; c < chunks; ++c) {
+                stage_chunk(c);
+            }
+        }
+
+        bool overflow = false;
+        staged_max_ = 0;
+        for (const auto& stats : chunk_stats_) {
+            staged_max_ = std::max(staged_max_, stats.staged_max);
+            frame_max_ = std::max(frame_max_, stats.frame_max);
+            carries_ += stats.carries;
+            overflow |= stats.overflow;
+        }
+        ++staged_frames_;
+
+        if (staged_max_ > std::numeric_limits<uint32_t>::max() - frame_max_) {
+            overflow |= flush(workers);
+        }
+        return overflow;
+    }
+
+    /**
+     * @brief Move all staged counts into the 64-bit sum
+     * @return true if at least one bin was capped at UINT64_MAX
+     */
+    bool flush(WorkerPool* workers = nullptr) {
+        if (staged_frames_ == 0) {
+            return false;
+        }
+        size_t chunks = sum_.chunk_count();
+        std::vector<char> overflow(chunks, 0);
+        auto flush_chunk = [&](size_t c) {
+            Span<uint64_t> sum = sum_.chunk(c);
+            uint32_t* staging = staging_for(c);
+            bool wrapped_any = false;
+            for (size_t i = 0; i < sum.size(); ++i) {
+                uint64_t value = sum[i] + staging[i];
+                bool wrapped = value < sum[i];
+                wrapped_any |= wrapped;
+                sum[i] = wrapped ? std::numeric_limits<uint64_t>::max() : value;
+                staging[i] = 0;
+            }
+            overflow[c] = wrapped_any;
+        };
+        if (workers) {
+            workers->run(chunks, flush_chunk);
+        } else {
+            for (size_t c = 0; c < chunks; ++c) {
+                flush_chunk(c);
+            }
+        }
+        staged_max_ = 0;
+        staged_frames_ = 0;
+        ++flushes_;
+        for (char wrapped : overflow) {
+            if (wrapped) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Flush and return the complete 64-bit running sum
+     */
+    const RunningSum& snapshot(WorkerPool* workers = nullptr) {
+        flush(workers);
+        return sum_;
+    }
+
+    /**
+     * @brief false once the largest frame count leaves too little 32-bit headroom
+     */
+    bool staging_enabled() const {
+        return frame_max_ <= std::numeric_limits<uint32_t>::max() / MIN_FRAMES_PER_FLUSH;
+    }
+
+    uint64_t flushes() const { return flushes_; }
+    // Frames added straight into the 64-bit sum because staging was disabled
+    uint64_t direct_frames() const { return direct_frames_; }
+    // Bins that wrapped in staging because a frame beat the headroom estimate
+    uint64_t carries() const { return carries_; }
+
+private:
+    static uint64_t saturating_add(uint64_t a, uint64_t b) {
+        uint64_t value = a + b;
+        return value < a ? std::numeric_limits<uint64_t>::max() : value;
+    }
+
+    // Staging bins of running-sum chunk c, contiguous within one staging chunk
+    uint32_t* staging_for(size_t chunk) {
+        size_t offset = sum_.chunk_offset(chunk);
+        return staging_.chunk(offset / Staging::CHUNK_ELEMENTS).data() + offset % Staging::CHUNK_ELEMENTS;
+    }
+    const uint32_t* staging_for(size_t chunk) const {
+        size_t offset = sum_.chunk_offset(chunk);
+        return staging_.chunk(offset / Staging::CHUNK_ELEMENTS).data() + offset % Staging::CHUNK_ELEMENTS;
+    }
+
+    RunningSum sum_;
+    Staging staging_;
+    std::vector<accumulate::StageStats> chunk_stats_;
+    uint32_t staged_max_ = 0;      // Largest staged count (exact: every frame covers every bin)
+    uint32_t frame_max_ = 0;       // Largest single-bin count seen in any frame
+    uint64_t staged_frames_ = 0;   // Frames since the last flush
+    uint64_t flushes_ = 0;
+    uint64_t carries_ = 0;
+    uint64_t direct_frames_ = 0;
+};
+
+#endif // TPX3_STAGED_SUM_H
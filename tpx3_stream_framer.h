@@ -0,0 +1,426 @@
+#ifndef TPX3_STREAM_FRAMER_H
+#define TPX3_STREAM_FRAMER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tpx3_frame_pool.h"
+#include "tpx3_header_parser.h"
+#include "tpx3_spsc_ring.h"
+
+constexpr size_t DEFAULT_RECEIVE_RING_SIZE = 65536;
+constexpr size_t MAX_HEADER_LINE = 4096;
+
+// Every header the server sends starts with this key
+constexpr char FRAME_HEADER_PREFIX[] = "{\"frameNumber\":";
+constexpr size_t FRAME_HEADER_PREFIX_LENGTH = sizeof(FRAME_HEADER_PREFIX) - 1;
+
+/**
+ * @brief Incremental framing state machine for the TPX3 histogram stream
+ *
+ * The stream is a sequence of frames, each a JSON header line followed by
+ * exactly binSize * 4 payload bytes. Received bytes go into a power-of-two
+ * ring buffer (nothing is ever moved), and drain() extracts every complete
+ * frame currently buffered in one pass. Once the buffered bytes of a payload
+ * are consumed, write_region() points straight into the frame's pooled
+ * buffer so the rest of a large payload is received without an extra copy.
+ *
+ * A header that does not parse, disagrees with its own payload length or
+ * never ends puts the framer into RESYNC: it scans forward for the next
+ * FRAME_HEADER_PREFIX whose line is a valid header and resumes there,
+ * counting skipped bytes and the frames lost according to frameNumber.
+ *
+ * Usage per read: write_region() -> recv() into it -> commit(n) -> drain().
+ */
+class StreamFramer {
+public:
+    using FrameSink = std::function<void(FrameBuffer*)>;
+
+    StreamFramer(FramePool& pool, size_t ring_size = DEFAULT_RECEIVE_RING_SIZE)
+        : pool_(pool), ring_(round_up_pow2(std::max(ring_size, MAX_HEADER_LINE * 2))),
+          mask_(ring_.size() - 1) {
+        header_scratch_.reserve(MAX_HEADER_LINE);
+    }
+
+    ~StreamFramer() {
+        reset();
+    }
+
+    // Disable copy
+    StreamFramer(const StreamFramer&) = delete;
+    StreamFramer& operator=(const StreamFramer&) = delete;
+
+    /**
+     * @brief Contiguous region the next recv() should write into
+     * @return Pointer and length; the length is never zero
+     */
+    std::pair<char*, size_t> write_region() {
+        if (state_ == State::PAYLOAD && buffered() == 0) {
+            // Receive the rest of the payload directly into the frame buffer
+            return {frame_->bytes() + payload_have_, payload_needed_ - payload_have_};
+        }
+
+        size_t offset = tail_ & mask_;
+        size_t free_bytes = ring_.size() - buffered();
+        return {ring_.data() + offset, std::min(free_bytes, ring_.size() - offset)};
+    }
+
+    /**
+     * @brief Account for n bytes written into the last write_region()
+     */
+    void commit(size_t n) {
+        bytes_received_ += n;
+        if (state_ == State::PAYLOAD && buffered() == 0) {
+            payload_have_ += n;
+        } else {
+            tail_ += n;
+        }
+    }
+
+    /**
+     * @brief Extract every complete frame currently buffered
+     * @param sink Called with each completed frame; takes ownership of the buffer
+     * @return Number of frames delivered
+     */
+    size_t drain(const FrameSink& sink) {
+        size_t delivered = 0;
+
+        while (true) {
+            if (state_ == State::HEADER) {
+                if (!take_header()) {
+                    break;
+                }
+            }
+
+            if (state_ == State::RESYNC) {
+                if (!resync()) {
+                    break;
+                }
+            }
+
+            if (state_ == State::PAYLOAD) {
+                copy_buffered_payload();
+                if (payload_have_ < payload_needed_) {
+                    break;
+                }
+
+                FrameBuffer* frame = frame_;
+                frame_ = nullptr;
+                state_ = State::HEADER;
+                ++frames_;
+                ++delivered;
+                sink(frame);
+            }
+        }
+
+        return delivered;
+    }
+
+    /**
+     * @brief Copy bytes received elsewhere into the framer and extract complete frames
+     * @param data Received bytes
+     * @param length Number of bytes
+     * @param sink Called with each completed frame; takes ownership of the buffer
+     * @return Number of frames delivered
+     *
+     * Goes through write_region(), so payload bytes are copied straight into
+     * the frame buffer whenever no header bytes are pending.
+     */
+    size_t feed(const char* data, size_t length, const FrameSink& sink) {
+        size_t delivered = 0;
+        while (length > 0) {
+            auto region = write_region();
+            size_t n = std::min(length, region.second);
+            memcpy(region.first, data, n);
+            commit(n);
+            delivered += drain(sink);
+            data += n;
+            length -= n;
+        }
+        return delivered;
+    }
+
+    /**
+     * @brief Drop buffered bytes and any partially received frame
+     * @return true if a partial frame or header was pending
+     */
+    bool reset() {
+        bool partial = state_ == State::PAYLOAD || buffered() > 0;
+        if (frame_) {
+            pool_.release_from_producer(frame_);
+            frame_ = nullptr;
+        }
+        discard_buffered();
+        state_ = State::HEADER;
+        has_last_frame_number_ = false;
+        return partial;
+    }
+
+    uint64_t frames() const { return frames_; }
+    uint64_t resyncs() const { return resyncs_; }
+    uint64_t skipped_bytes() const { return skipped_bytes_; }
+    uint64_t lost_frames() const { return lost_frames_; }
+    uint64_t bytes_received() const { return bytes_received_; }
+    uint64_t pool_stalls() const { return pool_stalls_; }
+
+private:
+    enum class State {
+        HEADER,    // Looking for the newline ending a JSON header
+        PAYLOAD,   // Collecting binSize * 4 payload bytes
+        RESYNC     // Scanning for the next valid header after corruption
+    };
+
+    static size_t round_up_pow2(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    size_t buffered() const { return tail_ - head_; }
+
+    void discard_buffered() {
+        head_ = tail_;
+        scanned_ = 0;
+    }
+
+    /**
+     * @brief Find the next newline in the buffered bytes
+     * @return Distance from head_, or SIZE_MAX if none is buffered yet
+     */
+    size_t find_newline() {
+        while (scanned_ < buffered()) {
+            size_t offset = (head_ + scanned_) & mask_;
+            size_t length = std::min(buffered() - scanned_, ring_.size() - offset);
+            const void* hit = memchr(ring_.data() + offset, '\n', length);
+            if (hit) {
+                return scanned_ + (static_cast<const char*>(hit) - (ring_.data() + offset));
+            }
+            scanned_ += length;
+        }
+        return SIZE_MAX;
+    }
+
+    /**
+     * @brief Pointer to a complete line of line_length bytes starting at head_
+     *
+     * Lines wrapping around the end of the ring are stitched into a scratch buffer.
+     */
+    const char* line_at_head(size_t line_length) {
+        size_t offset = head_ & mask_;
+        if (offset + line_length <= ring_.size()) {
+            return ring_.data() + offset;
+        }
+
+        size_t first = ring_.size() - offset;
+        header_scratch_.assign(ring_.data() + offset, ring_.data() + ring_.size());
+        header_scratch_.insert(header_scratch_.end(), ring_.data(),
+                               ring_.data() + (line_length - first));
+        return header_scratch_.data();
+    }
+
+    /**
+     * @brief Consume n buffered bytes
+     */
+    void advance(size_t n) {
+        head_ += n;
+        scanned_ = 0;
+    }
+
+    /**
+     * @brief Consume one header line if complete and start its payload
+     * @return true if the state machine advanced
+     */
+    bool take_header() {
+        size_t line_length = find_newline();
+        if (line_length == SIZE_MAX) {
+            // Without a newline this far in, we are not looking at a header
+            if (scanned_ >= MAX_HEADER_LINE) {
+                enter_resync("header line exceeds " + std::to_string(MAX_HEADER_LINE) + " bytes");
+                return true;
+            }
+            return false;
+        }
+
+        if (line_length == 0) {
+            // Skip empty lines
+            advance(1);
+            return true;
+        }
+
+        const char* line = line_at_head(line_length);
+        FrameHeader header;
+        std::string error;
+        if (line_length > MAX_HEADER_LINE ||
+            !parse_frame_header(line, line + line_length, header, error)) {
+            enter_resync(error.empty() ? "header line too long" : error);
+            return true;
+        }
+
+        advance(line_length + 1);
+        start_payload(header);
+        return true;
+    }
+
+    /**
+     * @brief Switch to RESYNC, reporting why the stream is considered corrupt
+     */
+    void enter_resync(const std::string& reason) {
+        std::cerr << "Stream corrupt (" << reason << "), resynchronizing" << std::endl;
+        ++resyncs_;
+        resync_skipped_ = 0;
+        state_ = State::RESYNC;
+    }
+
+    /**
+     * @brief Drop n bytes while resynchronizing
+     */
+    void skip(size_t n) {
+        advance(n);
+        skipped_bytes_ += n;
+        resync_skipped_ += n;
+    }
+
+    /**
+     * @brief Compare buffered bytes at head_ with FRAME_HEADER_PREFIX
+     */
+    bool prefix_at_head() const {
+        for (size_t i = 0; i < FRAME_HEADER_PREFIX_LENGTH; ++i) {
+            if (ring_[(head_ + i) & mask_] != FRAME_HEADER_PREFIX[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Scan for the next valid header line and start its payload
+     * @return true once resynchronized, false if more data is needed
+     */
+    bool resync() {
+        // The line at head_ is the one that failed; never accept it again
+        if (resync_skipped_ == 0 && buffered() > 0) {
+            skip(1);
+        }
+
+        while (buffered() > 0) {
+            // Jump to the next candidate '{'
+            size_t offset = head_ & mask_;
+            size_t length = std::min(buffered(), ring_.size() - offset);
+            const void* hit = memchr(ring_.data() + offset, '{', length);
+            if (!hit) {
+                skip(length);
+                continue;
+            }
+            skip(static_cast<const char*>(hit) - (ring_.data() + offset));
+
+            if (buffered() < FRAME_HEADER_PREFIX_LENGTH) {
+                return false;
+            }
+            if (!prefix_at_head()) {
+                skip(1);
+                continue;
+            }
+
+            size_t line_length = find_newline();
+            if (line_length == SIZE_MAX || line_length > MAX_HEADER_LINE) {
+                if (scanned_ >= MAX_HEADER_LINE || line_length != SIZE_MAX) {
+                    skip(1);
+                    continue;
+                }
+                return false;
+            }
+
+            const char* line = line_at_head(line_length);
+            FrameHeader header;
+            std::string error;
+            if (!parse_frame_header(line, line + line_length, header, error)) {
+                skip(1);
+                continue;
+            }
+
+            uint64_t lost_before = lost_frames_;
+            advance(line_length + 1);
+            start_payload(header);
+            std::cerr << "Resynchronized at frame " << header.frame_number << " after skipping "
+                      << resync_skipped_ << " bytes (" << (lost_frames_ - lost_before)
+                      << " frames lost)" << std::endl;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Take a pooled buffer for the frame and switch to PAYLOAD
+     */
+    void start_payload(const FrameHeader& header) {
+        if (has_last_frame_number_ && header.frame_number > last_frame_number_ + 1) {
+            lost_frames_ += header.frame_number - last_frame_number_ - 1;
+        }
+        last_frame_number_ = header.frame_number;
+        has_last_frame_number_ = true;
+
+        SpinBackoff backoff;
+        bool stalled = false;
+        while (!(frame_ = pool_.try_acquire(header.bin_size))) {
+            stalled = true;
+            backoff.pause();
+        }
+        if (stalled) {
+            ++pool_stalls_;
+        }
+
+        frame_->header = header;
+        payload_needed_ = static_cast<size_t>(header.bin_size) * sizeof(uint32_t);
+        payload_have_ = 0;
+        state_ = State::PAYLOAD;
+    }
+
+    /**
+     * @brief Move buffered ring bytes into the current frame's payload
+     */
+    void copy_buffered_payload() {
+        while (payload_have_ < payload_needed_ && buffered() > 0) {
+            size_t offset = head_ & mask_;
+            size_t length = std::min({payload_needed_ - payload_have_, buffered(),
+                                      ring_.size() - offset});
+            memcpy(frame_->bytes() + payload_have_, ring_.data() + offset, length);
+            payload_have_ += length;
+            head_ += length;
+        }
+    }
+
+    FramePool& pool_;
+    std::vector<char> ring_;
+    const size_t mask_;
+    size_t head_ = 0;      // Next byte to consume (monotonic)
+    size_t tail_ = 0;      // Next byte to write (monotonic)
+    size_t scanned_ = 0;   // Bytes after head_ already searched for a newline
+    std::vector<char> header_scratch_;
+
+    State state_ = State::HEADER;
+    FrameBuffer* frame_ = nullptr;
+    size_t payload_needed_ = 0;
+    size_t payload_have_ = 0;
+
+    long long last_frame_number_ = 0;
+    bool has_last_frame_number_ = false;
+    size_t resync_skipped_ = 0;
+
+    uint64_t frames_ = 0;
+    uint64_t resyncs_ = 0;
+    uint64_t skipped_bytes_ = 0;
+    uint64_t lost_frames_ = 0;
+    uint64_t bytes_received_ = 0;
+    uint64_t pool_stalls_ = 0;
+};
+
+#endif // TPX3_STREAM_FRAMER_H
@@ -0,0 +1,87 @@
+#ifndef TPX3_TEXT_FORMAT_H
+#define TPX3_TEXT_FORMAT_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "tpx3_histogram_data.h"
+
+/**
+ * @brief Text histogram format rendered with std::to_chars
+ *
+ * Produces the same bytes as the original iostream writer (std::scientific
+ * with precision 9, i.e. printf "%.9e", for edges and floating-point counts;
+ * plain decimal for integer counts), but without locale lookups or stream
+ * state: every number is rendered straight into one buffer, which the caller
+ * reuses between files and writes out in one go.
+ */
+namespace text_format {
+
+// Longest "%.9e" rendering, e.g. "-1.234567890e-308"
+constexpr size_t MAX_DOUBLE_CHARS = 24;
+// Longest line: edge, tab, count (a double or up to 20 digits), newline
+constexpr size_t MAX_LINE_CHARS = MAX_DOUBLE_CHARS + 1 + MAX_DOUBLE_CHARS + 1;
+
+inline char* put_text(char* out, const char* text) {
+    size_t length = std::strlen(text);
+    std::memcpy(out, text, length);
+    return out + length;
+}
+
+inline char* put_number(char* out, double value) {
+    return std::to_chars(out, out + MAX_DOUBLE_CHARS, value, std::chars_format::scientific, 9).ptr;
+}
+
+template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+char* put_number(char* out, T value) {
+    return std::to_chars(out, out + MAX_DOUBLE_CHARS, value).ptr;
+}
+
+/**
+ * @brief Render a histogram into the start of out
+ * @param count_at count_at(i) is the count of bin i (integer or floating point)
+ * @param generation Written as a "# Generation:" header line unless 0
+ * @return Number of bytes rendered
+ *
+ * out only grows, so a buffer kept across calls stops allocating once it
+ * has held the largest histogram.
+ */
+template <typename CountAt>
+size_t format_histogram(std::vector<char>& out, const BinAxis& axis, const CountAt& count_at,
+                        uint64_t generation = 0) {
+    size_t bins = axis.bin_count();
+    size_t capacity = 128 + (bins + 1) * MAX_LINE_CHARS;
+    if (out.size() < capacity) {
+        out.resize(capacity);
+    }
+
+    char* p = out.data();
+    p = put_text(p, "# Time of Flight Histogram Data\n# Bins: ");
+    p = put_number(p, bins);
+    if (generation > 0) {
+        p = put_text(p, "\n# Generation: ");
+        p = put_number(p, generation);
+    }
+    p = put_text(p, "\n#\n");
+
+    for (size_t i = 0; i < bins; ++i) {
+        p = put_number(p, axis.edge(i));
+        *p++ = '\t';
+        p = put_number(p, count_at(i));
+        *p++ = '\n';
+    }
+    // Last bin edge
+    p = put_number(p, axis.edge(bins));
+    *p++ = '\n';
+
+    return static_cast<size_t>(p - out.data());
+}
+
+} // namespace text_format
+
+#endif // TPX3_TEXT_FORMAT_H
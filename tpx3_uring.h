@@ -0,0 +1,348 @@
+#ifndef TPX3_URING_H
+#define TPX3_URING_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <linux/io_uring.h>
+
+constexpr unsigned URING_QUEUE_DEPTH = 256;
+constexpr unsigned URING_BUFFER_COUNT = 256;       // Power of two, at most 32768
+constexpr size_t URING_BUFFER_SIZE = 64 * 1024;
+constexpr uint64_t URING_CANCEL_USER_DATA = UINT64_MAX;
+
+#ifdef IORING_RECV_MULTISHOT
+
+/**
+ * @brief Minimal io_uring receiver using multishot recv and a provided-buffer ring
+ *
+ * Talks to the kernel through the raw syscalls so no liburing dependency is
+ * needed. One multishot IORING_OP_RECV is kept posted per socket; the kernel
+ * picks a buffer from a registered ring of URING_BUFFER_COUNT cache-aligned
+ * buffers for every completion, so a stream of data costs no syscalls beyond
+ * the occasional re-arm. Completions are reaped straight from the shared CQ
+ * ring and each buffer is handed back by bumping the buffer ring's tail.
+ *
+ * The ring descriptor is pollable, so the owner can wait for completions
+ * with epoll alongside its other descriptors. Single-threaded use only.
+ */
+class UringReceiver {
+public:
+    /**
+     * @brief Set up a ring, or explain why io_uring cannot be used here
+     * @param error Receives the reason on failure
+     * @return Receiver, or nullptr if unavailable (old kernel, seccomp, ...)
+     */
+    static std::unique_ptr<UringReceiver> create(std::string& error) {
+        std::unique_ptr<UringReceiver> receiver(new UringReceiver());
+        if (!receiver->setup(error)) {
+            return nullptr;
+        }
+        return receiver;
+    }
+
+    ~UringReceiver() {
+        if (buffer_ring_) {
+            munmap(buffer_ring_, buffer_ring_size_);
+        }
+        if (sqes_) {
+            munmap(sqes_, sqes_size_);
+        }
+        if (cq_ring_ && cq_ring_ != sq_ring_) {
+            munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_) {
+            munmap(sq_ring_, sq_ring_size_);
+        }
+        if (ring_fd_ >= 0) {
+            close(ring_fd_);
+        }
+        std::free(buffers_);
+    }
+
+    // Disable copy
+    UringReceiver(const UringReceiver&) = delete;
+    UringReceiver& operator=(const UringReceiver&) = delete;
+
+    /**
+     * @brief Ring descriptor; readable while completions are pending
+     */
+    int fd() const { return ring_fd_; }
+
+    /**
+     * @brief Post a multishot recv on a connected socket
+     * @param socket_fd Socket to receive from
+     * @param user_data Tag returned with every completion of this request
+     * @return false if the submission failed
+     */
+    bool arm_recv(int socket_fd, uint64_t user_data) {
+        io_uring_sqe* sqe = next_sqe();
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = socket_fd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = BUFFER_GROUP;
+        sqe->user_data = user_data;
+        return submit();
+    }
+
+    /**
+     * @brief Cancel the request posted with user_data (its completions may still arrive)
+     */
+    bool cancel(uint64_t user_data) {
+        io_uring_sqe* sqe = next_sqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = user_data;
+        sqe->user_data = URING_CANCEL_USER_DATA;
+        return submit();
+    }
+
+    /**
+     * @brief Process every pending completion
+     * @param on_completion Called as (user_data, result, more, data) where data
+     *        points to result bytes when result > 0 and more tells whether the
+     *        multishot request is still posted
+     * @return Number of completions processed
+     */
+    template <typename Callback>
+    size_t reap(Callback&& on_completion) {
+        // Entries the kernel could not post are flushed into the CQ by a GETEVENTS enter
+        if (__atomic_load_n(sq_flags_, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW) {
+            enter(0, 0, IORING_ENTER_GETEVENTS);
+        }
+
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        size_t processed = 0;
+
+        while (head != tail) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            if (cqe.user_data != URING_CANCEL_USER_DATA) {
+                const char* data = nullptr;
+                bool has_buffer = cqe.flags & IORING_CQE_F_BUFFER;
+                unsigned buffer_id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+                if (has_buffer) {
+                    data = buffers_ + static_cast<size_t>(buffer_id) * URING_BUFFER_SIZE;
+                }
+
+                on_completion(cqe.user_data, cqe.res, (cqe.flags & IORING_CQE_F_MORE) != 0, data);
+
+                if (has_buffer) {
+                    recycle_buffer(buffer_id);
+                }
+            }
+            ++head;
+            ++processed;
+        }
+
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        publish_buffers();
+        return processed;
+    }
+
+    /**
+     * @brief io_uring_enter() calls made so far (submissions and overflow flushes)
+     */
+    uint64_t enter_calls() const { return enter_calls_; }
+
+private:
+    static constexpr uint16_t BUFFER_GROUP = 0;
+
+    UringReceiver() = default;
+
+    static int sys_setup(unsigned entries, io_uring_params* params) {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    static int sys_register(int fd, unsigned opcode, void* arg, unsigned count) {
+        return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+    }
+
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+        ++enter_calls_;
+        return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit,
+                                        min_complete, flags, nullptr, 0));
+    }
+
+    bool setup(std::string& error) {
+        io_uring_params params{};
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = URING_BUFFER_COUNT * 4;
+
+        ring_fd_ = sys_setup(URING_QUEUE_DEPTH, &params);
+        if (ring_fd_ < 0) {
+            error = std::string("io_uring_setup: ") + strerror(errno);
+            return false;
+        }
+        if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+            error = "kernel lacks IORING_FEAT_SINGLE_MMAP";
+            return false;
+        }
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        cq_ring_size_ = sq_ring_size_;
+
+        sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED) {
+            sq_ring_ = nullptr;
+            error = std::string("mmap SQ ring: ") + strerror(errno);
+            return false;
+        }
+        cq_ring_ = sq_ring_;
+
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            error = std::string("mmap SQEs: ") + strerror(errno);
+            return false;
+        }
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        char* sq = static_cast<char*>(sq_ring_);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sq_flags_ = reinterpret_cast<unsigned*>(sq + params.sq_off.flags);
+
+        char* cq = static_cast<char*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        return setup_buffer_ring(error);
+    }
+
+    bool setup_buffer_ring(std::string& error) {
+        buffers_ = static_cast<char*>(
+            std::aligned_alloc(64, static_cast<size_t>(URING_BUFFER_COUNT) * URING_BUFFER_SIZE));
+        if (!buffers_) {
+            error = "cannot allocate receive buffers";
+            return false;
+        }
+
+        buffer_ring_size_ = URING_BUFFER_COUNT * sizeof(io_uring_buf);
+        void* ring = mmap(nullptr, buffer_ring_size_, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ring == MAP_FAILED) {
+            error = std::string("mmap buffer ring: ") + strerror(errno);
+            return false;
+        }
+        buffer_ring_ = static_cast<io_uring_buf_ring*>(ring);
+
+        io_uring_buf_reg registration{};
+        registration.ring_addr = reinterpret_cast<uint64_t>(buffer_ring_);
+        registration.ring_entries = URING_BUFFER_COUNT;
+        registration.bgid = BUFFER_GROUP;
+        if (sys_register(ring_fd_, IORING_REGISTER_PBUF_RING, &registration, 1) < 0) {
+            error = std::string("register buffer ring: ") + strerror(errno);
+            return false;
+        }
+
+        for (unsigned id = 0; id < URING_BUFFER_COUNT; ++id) {
+            recycle_buffer(id);
+        }
+        publish_buffers();
+        return true;
+    }
+
+    void recycle_buffer(unsigned id) {
+        // Index from the ring base: in C++ the header's flexible-array wrapper
+        // gives `bufs` a one-byte empty member, which shifts it by 8 bytes
+        io_uring_buf* slots = reinterpret_cast<io_uring_buf*>(buffer_ring_);
+        io_uring_buf& slot = slots[buffer_tail_ & (URING_BUFFER_COUNT - 1)];
+        slot.addr = reinterpret_cast<uint64_t>(buffers_ + static_cast<size_t>(id) * URING_BUFFER_SIZE);
+        slot.len = URING_BUFFER_SIZE;
+        slot.bid = static_cast<uint16_t>(id);
+        ++buffer_tail_;
+    }
+
+    void publish_buffers() {
+        __atomic_store_n(&buffer_ring_->tail, buffer_tail_, __ATOMIC_RELEASE);
+    }
+
+    io_uring_sqe* next_sqe() {
+        unsigned tail = *sq_tail_;
+        unsigned index = tail & sq_mask_;
+        io_uring_sqe* sqe = &sqes_[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sq_array_[index] = index;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        return sqe;
+    }
+
+    bool submit() {
+        int submitted;
+        do {
+            submitted = enter(1, 0, 0);
+        } while (submitted < 0 && errno == EINTR);
+        return submitted >= 0;
+    }
+
+    int ring_fd_ = -1;
+
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned* sq_flags_ = nullptr;
+    unsigned sq_mask_ = 0;
+
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+
+    char* buffers_ = nullptr;
+    io_uring_buf_ring* buffer_ring_ = nullptr;
+    size_t buffer_ring_size_ = 0;
+    uint16_t buffer_tail_ = 0;
+
+    uint64_t enter_calls_ = 0;
+};
+
+#else // !IORING_RECV_MULTISHOT
+
+/**
+ * @brief Stand-in for kernel headers older than 6.0; always reports io_uring as unavailable
+ */
+class UringReceiver {
+public:
+    static std::unique_ptr<UringReceiver> create(std::string& error) {
+        error = "built against kernel headers without multishot recv";
+        return nullptr;
+    }
+
+    int fd() const { return -1; }
+    bool arm_recv(int, uint64_t) { return false; }
+    bool cancel(uint64_t) { return false; }
+
+    template <typename Callback>
+    size_t reap(Callback&&) { return 0; }
+
+    uint64_t enter_calls() const { return 0; }
+};
+
+#endif // IORING_RECV_MULTISHOT
+
+#endif // TPX3_URING_H
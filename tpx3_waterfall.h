@@ -0,0 +1,281 @@
+#ifndef TPX3_WATERFALL_H
+#define TPX3_WATERFALL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tpx3_histogram_data.h"
+
+constexpr char WATERFALL_MAGIC[8] = {'T', 'P', 'X', '3', 'W', 'F', 'A', 'L'};
+constexpr uint32_t WATERFALL_VERSION = 1;
+
+/**
+ * @brief How waterfall rows are cut: every F frame numbers or every S seconds
+ */
+struct WaterfallSpec {
+    uint64_t frames = 0;    // Frame-number interval per row (0 = not frame-based)
+    double seconds = 0.0;   // Wall-clock interval per row (0 = not time-based)
+    size_t rows = 1024;     // Ring capacity; older rows are overwritten
+    uint64_t max_bytes = uint64_t{1} << 30;  // Limit on the ring, rows x bins x 4 bytes
+
+    bool enabled() const { return frames > 0 || seconds > 0.0; }
+
+    /**
+     * @brief Largest bin count whose ring fits in max_bytes (0 if not even one bin fits)
+     */
+    uint64_t max_bins() const { return rows == 0 ? 0 : max_bytes / rows / sizeof(uint32_t); }
+
+    /**
+     * @brief Throw std::length_error if a ring of bins bins would exceed max_bytes
+     */
+    void check_size(size_t bins) const {
+        if (bins > max_bins()) {
+            double mib = static_cast<double>(rows) * bins * sizeof(uint32_t) / (1024.0 * 1024.0);
+            throw std::length_error("a waterfall of " + std::to_string(rows) + " rows x " + std::to_string(bins) +
+                                    " bins needs " + std::to_string(static_cast<uint64_t>(mib + 0.5)) +
+                                    " MiB, more than the limit of " + std::to_string(max_bytes >> 20) + " MiB");
+        }
+    }
+};
+
+/**
+ * @brief Metadata of one waterfall row, written to disk as is
+ */
+struct WaterfallRowInfo {
+    int64_t first_frame = 0;
+    int64_t last_frame = 0;
+    int64_t start_ns = 0;
+    uint32_t frames = 0;
+    uint32_t reserved = 0;
+};
+static_assert(sizeof(WaterfallRowInfo) == 32, "WaterfallRowInfo is written to disk as is");
+
+/**
+ * @brief One waterfall row: its metadata and one 32-bit count per bin
+ */
+struct WaterfallRow {
+    WaterfallRowInfo info;
+    std::vector<uint32_t> counts;
+};
+
+/**
+ * @brief Cuts frames into waterfall rows (accumulation side)
+ *
+ * Only the row being filled is kept. When a frame falls into the next
+ * frame-number or time interval, the filled row is handed out whole, so the
+ * ring and its file can live on another thread. Counts saturate at
+ * UINT32_MAX within a row.
+ */
+class WaterfallBuilder {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @throws std::length_error if the ring for this many bins would exceed spec.max_bytes
+     */
+    WaterfallBuilder(std::shared_ptr<const BinAxis> axis, const WaterfallSpec& spec)
+        : axis_(std::move(axis)), spec_(spec), bins_(axis_->bin_count()) {
+        if (!spec.enabled() || spec.rows == 0) {
+            throw std::invalid_argument("Waterfall needs a row interval and at least one row");
+        }
+        spec.check_size(bins_);
+    }
+
+    const BinAxis& axis() const { return *axis_; }
+    const std::shared_ptr<const BinAxis>& shared_axis() const { return axis_; }
+    bool has_row() const { return has_row_; }
+
+    /**
+     * @brief Add one frame to the row its frame number or arrival time falls into
+     * @param count_at count_at(i) is the count of bin i
+     * @param completed Receives the previous row if this frame starts a new one
+     * @return true if a row was completed
+     */
+    template <typename CountAt>
+    bool add(int64_t frame_number, size_t count, const CountAt& count_at, WaterfallRow& completed,
+             Clock::time_point now = Clock::now()) {
+        if (count != bins_) {
+            throw std::invalid_argument("Bin sizes must match for addition");
+        }
+        int64_t key = row_key(frame_number, now);
+        bool new_row = !has_row_ || key != current_key_;
+        bool complete = new_row && has_row_;
+        if (complete) {
+            completed = take_row();
+        }
+        if (new_row) {
+            start_row(key, frame_number);
+        }
+
+        uint32_t* row = row_.counts.data();
+        for (size_t i = 0; i < bins_; ++i) {
+            uint64_t value = uint64_t{row[i]} + count_at(i);
+            row[i] = value > std::numeric_limits<uint32_t>::max()
+                ? std::numeric_limits<uint32_t>::max() : static_cast<uint32_t>(value);
+        }
+        row_.info.last_frame = frame_number;
+        ++row_.info.frames;
+        return complete;
+    }
+
+    /**
+     * @brief Hand out the row being filled, e.g. on exit; the next frame starts a new row
+     */
+    WaterfallRow take_row() {
+        has_row_ = false;
+        return std::move(row_);
+    }
+
+private:
+    int64_t row_key(int64_t frame_number, Clock::time_point now) {
+        if (spec_.frames > 0) {
+            int64_t interval = static_cast<int64_t>(spec_.frames);
+            return frame_number >= 0 ? frame_number / interval : (frame_number - interval + 1) / interval;
+        }
+        if (!started_) {
+            origin_ = now;
+            started_ = true;
+        }
+        return static_cast<int64_t>(std::chrono::duration<double>(now - origin_).count() / spec_.seconds);
+    }
+
+    void start_row(int64_t key, int64_t frame_number) {
+        row_.counts.assign(bins_, 0);
+        row_.info = WaterfallRowInfo{};
+        row_.info.first_frame = frame_number;
+        row_.info.start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        current_key_ = key;
+        has_row_ = true;
+    }
+
+    std::shared_ptr<const BinAxis> axis_;
+    WaterfallSpec spec_;
+    size_t bins_;
+    WaterfallRow row_;              // Row currently being filled
+    bool has_row_ = false;
+    int64_t current_key_ = 0;
+    Clock::time_point origin_;
+    bool started_ = false;
+};
+
+/**
+ * @brief Time-resolved ToF view: the latest rows of a WaterfallBuilder, written to disk
+ *
+ * Rows live in one row-major ring of fixed capacity (rows x bins 32-bit
+ * counts), so memory never grows. When the ring is full the oldest row is
+ * reused.
+ *
+ * dump() writes the ring oldest row first in a compact binary layout (host
+ * byte order, i.e. little-endian on x86):
+ *   char[8]  magic "TPX3WFAL"
+ *   u32      version (1)
+ *   u32      bins
+ *   u32      rows stored
+ *   u32      mode (0 = frame-number rows, 1 = time rows)
+ *   f64      row interval (frames or seconds)
+ *   i32      binWidth, i32 binOffset (TDC ticks)
+ *   f64      TDC clock period in seconds
+ *   rows x { i64 first frame number, i64 last frame number,
+ *            i64 start time (ns since the Unix epoch), u32 frames, u32 reserved }
+ *   rows x bins u32 counts
+ */
+class Waterfall {
+public:
+    Waterfall(std::shared_ptr<const BinAxis> axis, const WaterfallSpec& spec)
+        : axis_(std::move(axis)), spec_(spec), bins_(axis_->bin_count()) {
+        if (!spec.enabled() || spec.rows == 0) {
+            throw std::invalid_argument("Waterfall needs a row interval and at least one row");
+        }
+        spec.check_size(bins_);
+        counts_.assign(spec.rows * bins_, 0);
+        rows_.resize(spec.rows);
+    }
+
+    const BinAxis& axis() const { return *axis_; }
+    size_t row_count() const { return stored_; }
+    size_t capacity() const { return rows_.size(); }
+    uint64_t rows_started() const { return rows_started_; }
+
+    /**
+     * @brief Append a row, overwriting the oldest one once the ring is full
+     */
+    void push(const WaterfallRow& row) {
+        if (row.counts.size() != bins_) {
+            throw std::invalid_argument("Bin sizes must match for addition");
+        }
+        newest_ = stored_ == 0 ? 0 : (newest_ + 1) % capacity();
+        stored_ = std::min(stored_ + 1, capacity());
+        std::memcpy(counts_.data() + newest_ * bins_, row.counts.data(), bins_ * sizeof(uint32_t));
+        rows_[newest_] = row.info;
+        ++rows_started_;
+    }
+
+    /**
+     * @brief Write the ring to path (via a temporary file, so readers never see half a dump)
+     * @return true on success
+     */
+    bool dump(const std::string& path) const {
+        std::string temp = path + ".tmp";
+        FILE* file = std::fopen(temp.c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+
+        uint32_t mode = spec_.frames > 0 ? 0 : 1;
+        double interval = spec_.frames > 0 ? static_cast<double>(spec_.frames) : spec_.seconds;
+        uint32_t bins = static_cast<uint32_t>(bins_);
+        uint32_t rows = static_cast<uint32_t>(stored_);
+        int32_t width = axis_->bin_width();
+        int32_t offset = axis_->bin_offset();
+        double period = axis_->clock_period();
+
+        bool ok = std::fwrite(WATERFALL_MAGIC, sizeof(WATERFALL_MAGIC), 1, file) == 1 &&
+                  std::fwrite(&WATERFALL_VERSION, sizeof(uint32_t), 1, file) == 1 &&
+                  std::fwrite(&bins, sizeof(bins), 1, file) == 1 &&
+                  std::fwrite(&rows, sizeof(rows), 1, file) == 1 &&
+                  std::fwrite(&mode, sizeof(mode), 1, file) == 1 &&
+                  std::fwrite(&interval, sizeof(interval), 1, file) == 1 &&
+                  std::fwrite(&width, sizeof(width), 1, file) == 1 &&
+                  std::fwrite(&offset, sizeof(offset), 1, file) == 1 &&
+                  std::fwrite(&period, sizeof(period), 1, file) == 1;
+
+        // The ring holds at most two contiguous runs, oldest first
+        size_t oldest = (newest_ + capacity() + 1 - stored_) % capacity();
+        size_t first_run = std::min(stored_, capacity() - oldest);
+        ok = ok && std::fwrite(rows_.data() + oldest, sizeof(WaterfallRowInfo), first_run, file) == first_run &&
+             std::fwrite(rows_.data(), sizeof(WaterfallRowInfo), stored_ - first_run, file) == stored_ - first_run &&
+             std::fwrite(counts_.data() + oldest * bins_, sizeof(uint32_t), first_run * bins_, file) ==
+                 first_run * bins_ &&
+             std::fwrite(counts_.data(), sizeof(uint32_t), (stored_ - first_run) * bins_, file) ==
+                 (stored_ - first_run) * bins_;
+
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok || std::rename(temp.c_str(), path.c_str()) != 0) {
+            std::remove(temp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::shared_ptr<const BinAxis> axis_;
+    WaterfallSpec spec_;
+    size_t bins_;
+    std::vector<uint32_t> counts_;  // Row-major ring, capacity() x bins_
+    std::vector<WaterfallRowInfo> rows_;
+    size_t newest_ = 0;             // Most recently pushed row
+    size_t stored_ = 0;             // Rows holding data, up to capacity()
+    uint64_t rows_started_ = 0;
+};
+
+#endif // TPX3_WATERFALL_H
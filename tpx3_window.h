@@ -0,0 +1,174 @@
+#ifndef TPX3_WINDOW_H
+#define TPX3_WINDOW_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "tpx3_histogram_data.h"
+#include "tpx3_span.h"
+
+/**
+ * @brief Length of a sliding window, in frames or in seconds
+ */
+struct WindowSpec {
+    size_t frames = 0;     // Last N frames (0 = not frame-based)
+    double seconds = 0.0;  // Last T seconds (0 = not time-based)
+    size_t slots = 10;     // Partial sums the window is split into
+
+    bool enabled() const { return frames > 0 || seconds > 0.0; }
+};
+
+/**
+ * @brief Sum over the last N frames or T seconds, kept as a ring of partial sums
+ *
+ * The window is split into a fixed number of slots, each holding the partial
+ * sum of the frames that arrived during it. A frame is added to the current
+ * slot and to the window sum in one pass over its payload. When a slot
+ * expires, its partial sum is subtracted from the window sum and the slot is
+ * reused, so each frame costs O(bins) whatever the window length, and memory
+ * is bounded by (slots + 1) * bins 64-bit counters. The window moves in
+ * steps of one slot: it holds the current, partly filled slot plus the
+ * slots - 1 before it.
+ */
+class SlidingWindowSum {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    SlidingWindowSum(std::shared_ptr<const BinAxis> axis, const WindowSpec& spec)
+        : axis_(std::move(axis)), bins_(axis_->bin_count()), window_(bins_, 0) {
+        if (!spec.enabled() || spec.slots == 0) {
+            throw std::invalid_argument("Sliding window needs a length and at least one slot");
+        }
+        size_t slots = spec.slots;
+        if (spec.frames > 0) {
+            slot_frames_ = (spec.frames + slots - 1) / slots;
+            slots = (spec.frames + slot_frames_ - 1) / slot_frames_;
+        } else {
+            slot_duration_ = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(spec.seconds / static_cast<double>(slots)));
+            slot_duration_ = std::max(slot_duration_, Clock::duration(1));
+        }
+        slots_.assign(slots * bins_, 0);
+        slot_frame_count_.assign(slots, 0);
+    }
+
+    const BinAxis& axis() const { return *axis_; }
+    size_t get_bin_size() const { return bins_; }
+    size_t slot_count() const { return slot_frame_count_.size(); }
+
+    Span<const uint64_t> values() const { return {window_.data(), window_.size()}; }
+    uint64_t value(size_t index) const { return window_[index]; }
+
+    /**
+     * @brief Write the window sum of every bin to out
+     */
+    void copy_values(uint64_t* out) const { std::memcpy(out, window_.data(), window_.size() * sizeof(uint64_t)); }
+
+    /**
+     * @brief Frames currently contributing to the window sum
+     */
+    uint64_t frames_in_window() const { return frames_in_window_; }
+
+    /**
+     * @brief Add one frame
+     * @param count(i) Count of bin i (e.g. a byte-swapping read of the wire payload)
+     * @param now Arrival time; only used by time-based windows
+     */
+    template <typename CountAt>
+    void add(size_t count, const CountAt& count_at, Clock::time_point now = Clock::now()) {
+        if (count != bins_) {
+            throw std::invalid_argument("Bin sizes must match for addition");
+        }
+        advance(now);
+
+        uint64_t* slot = slots_.data() + current_ * bins_;
+        uint64_t* window = window_.data();
+        for (size_t i = 0; i < bins_; ++i) {
+            uint64_t value = count_at(i);
+            slot[i] += value;
+            window[i] += value;
+        }
+        ++slot_frame_count_[current_];
+        ++frames_in_window_;
+    }
+
+    /**
+     * @brief Add big-endian 32-bit counts, as received
+     */
+    void add_be32(const uint32_t* wire, size_t count, Clock::time_point now = Clock::now()) {
+        add(count, [wire](size_t i) { return __builtin_bswap32(wire[i]); }, now);
+    }
+
+    /**
+     * @brief Expire the slots that ended by now, so a time window drains when frames stop
+     * @return true if the window sum changed; frame-based windows never change here
+     */
+    bool advance_to(Clock::time_point now) {
+        if (slot_frames_ > 0 || !started_) {
+            return false;
+        }
+        uint64_t frames = frames_in_window_;
+        advance(now);
+        return frames_in_window_ != frames;
+    }
+
+private:
+    /**
+     * @brief Move to the slot the next frame belongs to, expiring the ones it replaces
+     */
+    void advance(Clock::time_point now) {
+        size_t steps = 0;
+        if (slot_frames_ > 0) {
+            steps = slot_frame_count_[current_] >= slot_frames_ ? 1 : 0;
+        } else if (!started_) {
+            slot_start_ = now;
+            started_ = true;
+        } else if (now - slot_start_ >= slot_duration_) {
+            auto elapsed = static_cast<size_t>((now - slot_start_) / slot_duration_);
+            slot_start_ += slot_duration_ * elapsed;
+            steps = std::min(elapsed, slot_count());
+        }
+
+        for (size_t s = 0; s < steps; ++s) {
+            current_ = (current_ + 1) % slot_count();
+            expire(current_);
+        }
+    }
+
+    /**
+     * @brief Subtract a slot's partial sum from the window and clear it
+     */
+    void expire(size_t index) {
+        if (slot_frame_count_[index] == 0) {
+            return;
+        }
+        uint64_t* slot = slots_.data() + index * bins_;
+        uint64_t* window = window_.data();
+        for (size_t i = 0; i < bins_; ++i) {
+            window[i] -= slot[i];
+            slot[i] = 0;
+        }
+        frames_in_window_ -= slot_frame_count_[index];
+        slot_frame_count_[index] = 0;
+    }
+
+    std::shared_ptr<const BinAxis> axis_;
+    size_t bins_;
+    std::vector<uint64_t> window_;            // Sum of all slots
+    std::vector<uint64_t> slots_;             // Row-major partial sums, slot_count() x bins_
+    std::vector<uint64_t> slot_frame_count_;  // Frames in each slot
+    size_t current_ = 0;
+    uint64_t frames_in_window_ = 0;
+    size_t slot_frames_ = 0;                  // Frame-based: frames per slot
+    Clock::duration slot_duration_{};         // Time-based: length of one slot
+    Clock::time_point slot_start_;
+    bool started_ = false;
+};
+
+#endif // TPX3_WINDOW_H
@@ -0,0 +1,145 @@
+#ifndef TPX3_WORKER_POOL_H
+#define TPX3_WORKER_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Small fixed pool of threads for splitting one bulk operation into tasks
+ *
+ * run() hands out task indices 0..count-1 to the workers and the calling
+ * thread alike and returns once every task has finished. Only one run() may
+ * be in progress at a time (the accumulation thread is the only caller).
+ * Workers take the task and count under the lock, and run() returns only
+ * after every worker that joined has left, so the claim counter is never
+ * reset while a late worker is still claiming from it.
+ */
+class WorkerPool {
+public:
+    /**
+     * @param threads Total threads including the caller; 1 runs everything inline
+     */
+    explicit WorkerPool(size_t threads) {
+        for (size_t i = 1; i < threads; ++i) {
+            workers_.emplace_back(&WorkerPool::worker_loop, this);
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    // Disable copy
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    size_t thread_count() const { return workers_.size() + 1; }
+
+    /**
+     * @brief Run task(i) for every i in [0, count) and wait for all of them
+     */
+    void run(size_t count, const std::function<void(size_t)>& task) {
+        if (workers_.empty() || count <= 1) {
+            for (size_t i = 0; i < count; ++i) {
+                task(i);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            task_ = &task;
+            task_count_ = count;
+            next_task_.store(0, std::memory_order_relaxed);
+            finished_ = 0;
+            ++generation_;
+        }
+        wake_.notify_all();
+
+        size_t done = work(task, count);
+
+        // Wait for the workers to leave too, so none claims from the next run's counter
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_ += done;
+        done_.wait(lock, [this] { return finished_ == task_count_ && active_ == 0; });
+        task_ = nullptr;
+    }
+
+private:
+    /**
+     * @brief Claim and run tasks until none are left
+     * @return Number of tasks this thread ran
+     */
+    size_t work(const std::function<void(size_t)>& task, size_t count) {
+        size_t done = 0;
+        while (true) {
+            size_t index = next_task_.fetch_add(1, std::memory_order_relaxed);
+            if (index >= count) {
+                return done;
+            }
+            task(index);
+            ++done;
+        }
+    }
+
+    void worker_loop() {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) {
+                return;
+            }
+            seen = generation_;
+            if (!task_) {
+                continue;  // Woke after that run already returned
+            }
+            const std::function<void(size_t)>* task = task_;
+            size_t count = task_count_;
+            ++active_;
+            lock.unlock();
+            size_t done = work(*task, count);
+            lock.lock();
+            finished_ += done;
+            --active_;
+            if (finished_ == task_count_ && active_ == 0) {
+                done_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::function<void(size_t)>* task_ = nullptr;
+    size_t task_count_ = 0;
+    std::atomic<size_t> next_task_{0};
+    size_t finished_ = 0;
+    size_t active_ = 0;  // Workers inside work() for the current run
+    uint64_t generation_ = 0;
+    bool stopping_ = false;
+};
+
+/**
+ * @brief Default accumulation thread count: half the cores, between 1 and 8
+ */
+inline size_t default_worker_threads() {
+    size_t cores = std::thread::hardware_concurrency();
+    return std::min<size_t>(8, std::max<size_t>(1, cores / 2));
+}
+
+#endif // TPX3_WORKER_POOL_H